@@ -0,0 +1,844 @@
+// Benchmark suite for the scheduling core (mirrorbooking_bench).
+// Modeled on Google Benchmark: every case is timed over enough iterations to fill a minimum run time, the
+// cases that depend on the size of the store run once per synthetic dataset (1K to 10M appointments), and
+// results are printed as a table or written as Google Benchmark JSON, so runs from different releases can be
+// diffed with the same tools (e.g. its compare.py)
+//
+//   mirrorbooking_bench [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>]
+//                       [--benchmark_format=console|json] [--benchmark_out=<file.json>] [--max_records=<n>]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "appointment.h"
+#include "calendar.h"
+#include "journal.h"
+#include "prefixtrie.h"
+#include "render.h"
+#include "report.h"
+#include "schedule.h"
+#include "storage.h"
+#include "threadpool.h"
+#include "waitlist.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+// ---- Memory accounting ----
+
+// Every operator new in the process is counted, so each benchmark reports the allocations one iteration makes
+// (Google Benchmark's allocs_per_iter)
+std::atomic<size_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+// kept out of line: inlined into a delete expression, GCC would warn that new's memory is handed to free()
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void release(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory) noexcept { release(memory); }
+void operator delete(void* memory, std::size_t) noexcept { release(memory); }
+
+// heap bytes in use; 0 where the allocator can't tell
+size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd; // small blocks plus the ones big enough to get their own mapping
+#else
+    return 0;
+#endif
+}
+
+// resident set size of the process in bytes; 0 where it can't be read (only Linux has /proc/self/statm)
+size_t residentBytes() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+// hand memory freed by earlier benchmarks back to the OS, so a resident-size reading starts from what is live
+void trimHeap() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+enum class TimeUnit { ns, us, ms };
+
+// What a benchmark sees while it runs: the dataset size, the iteration loop and its counters.
+// Write the timed loop as while (state.keepRunning()) { ... }; setup before it isn't timed
+class State {
+public:
+    State(size_t range, size_t iterations) : range(range), iterations(iterations), left(iterations) {}
+
+    bool keepRunning() {
+        if (left == iterations) start();
+        if (left == 0) {
+            stop();
+            return false;
+        }
+        --left;
+        return true;
+    }
+
+    // leave work out of the timing (setup that has to happen inside the loop)
+    void pauseTiming() {
+        realSeconds += secondsSince(realStart);
+        cpuSeconds += cpuNow() - cpuStart;
+        allocations += allocationCount.load(std::memory_order_relaxed) - allocationStart;
+    }
+    void resumeTiming() { start(); }
+
+    const size_t range;      // dataset size, 0 for benchmarks that don't depend on it
+    const size_t iterations;
+    size_t itemsProcessed = 0;
+    size_t bytesProcessed = 0;
+    double realSeconds = 0;
+    double cpuSeconds = 0;
+    size_t allocations = 0;       // operator new calls while timed
+    size_t heapBytes = 0;         // what a benchmark that loads something keeps on the heap for it, if it says
+    size_t residentBytes = 0;     // and how much the process grew holding it (heap, mapped files and all)
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static double secondsSince(Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); }
+    static double cpuNow() { return static_cast<double>(std::clock()) / CLOCKS_PER_SEC; }
+    void start() {
+        realStart = Clock::now();
+        cpuStart = cpuNow();
+        allocationStart = allocationCount.load(std::memory_order_relaxed);
+    }
+    void stop() { pauseTiming(); }
+
+    size_t left;
+    Clock::time_point realStart;
+    double cpuStart = 0;
+    size_t allocationStart = 0;
+};
+
+// A synthetic store of a given size: a busy single-chair shop, about 11 appointments a day on the 15-minute
+// grid between 10am and 6pm, centered on today (so load windows around today see a realistic slice of it).
+// The text is shared (a pool of client names, one date string per day), as it would be in a loaded store
+struct Dataset {
+    size_t size = 0;
+    TextArena arena;
+    std::vector<Appointment> appointments;
+    ScheduleIndex index;
+    int firstDay = 0;
+    int lastDay = 0;
+    std::vector<int> sampleDays; // days spread over the whole store, for lookups and views
+    std::string textPath;        // the store saved as text and as a binary snapshot, written on first use
+    std::string binaryPath;
+
+    explicit Dataset(size_t records) : size(records) {
+        static const struct { const char* name; int duration; ServiceType kind; } services[] = {
+            {"hair", 30, ServiceType::hair}, {"beard", 15, ServiceType::beard},
+            {"full", 45, ServiceType::full}, {"30", 30, ServiceType::custom}};
+        std::mt19937 random(42);
+        std::vector<std::string_view> names;
+        for (int i = 0; i < 5000; ++i) names.push_back(arena.store("client" + std::to_string(i)));
+        std::vector<std::string_view> times(24 * 4);
+        for (int slot = 0; slot < 24 * 4; ++slot) times[slot] = arena.store(minutesToTime(slot * 15));
+
+        appointments.reserve(records);
+        int days = static_cast<int>(records / 11 + 1);
+        firstDay = getCurrentDay() - days / 2;
+        int day = firstDay;
+        while (appointments.size() < records) {
+            std::string_view date = arena.store(daysToDate(day));
+            int cursor = 10 * 60;
+            while (appointments.size() < records) {
+                const auto& service = services[random() % 4];
+                int start = cursor + static_cast<int>(random() % 2) * 15; // leave the odd gap
+                if (start + service.duration > 18 * 60) break;
+                Appointment apt;
+                apt.name = names[random() % names.size()];
+                apt.time = times[start / 15];
+                apt.date = date;
+                apt.service = service.name;
+                apt.duration = service.duration;
+                apt.start = start;
+                apt.day = day;
+                apt.kind = service.kind;
+                appointments.push_back(apt);
+                cursor = start + (service.duration + 14) / 15 * 15;
+            }
+            ++day;
+        }
+        lastDay = day - 1;
+        index.build(appointments);
+        for (int i = 0; i < 1024; ++i) {
+            sampleDays.push_back(firstDay + static_cast<int>(static_cast<long long>(lastDay - firstDay) * i / 1024));
+        }
+    }
+
+    ~Dataset() {
+        std::error_code ec;
+        if (!textPath.empty()) std::filesystem::remove(textPath, ec);
+        if (!binaryPath.empty()) std::filesystem::remove(binaryPath, ec);
+    }
+
+    const std::string& textFile() {
+        if (textPath.empty()) {
+            textPath = tempPath(".txt");
+            saveAppointments(appointments, textPath);
+        }
+        return textPath;
+    }
+    const std::string& binaryFile() {
+        if (binaryPath.empty()) {
+            binaryPath = tempPath(".mbk");
+            saveBinarySnapshot(appointments, binaryPath);
+        }
+        return binaryPath;
+    }
+
+private:
+    std::string tempPath(const char* extension) const {
+        return (std::filesystem::temp_directory_path() / ("mirrorbooking_bench_" + std::to_string(size) + extension)).string();
+    }
+};
+
+// Keeps the optimizer from dropping a result
+template <typename T>
+void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile char sink;
+    sink = *reinterpret_cast<const volatile char*>(&value);
+#endif
+}
+
+// ---- Helpers as they were before they were optimized, kept as baselines ----
+
+// the loader as it was before the mmap loader: one getline + istringstream + five std::strings per record
+size_t legacyLoad(const std::string& filename) {
+    struct LegacyAppointment {
+        std::string name, time, date, service;
+        int duration;
+    };
+    std::vector<LegacyAppointment> appointments;
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        LegacyAppointment apt;
+        std::string durationStr;
+        if (std::getline(iss, apt.name, '|') && std::getline(iss, apt.time, '|') &&
+            std::getline(iss, apt.date, '|') && std::getline(iss, apt.service, '|') &&
+            std::getline(iss, durationStr)) {
+            apt.duration = std::stoi(durationStr);
+            appointments.push_back(apt);
+        }
+    }
+    return appointments.size();
+}
+
+// the std::get_time/mktime/localtime date helpers the day-number math replaced
+std::tm legacyParse(const std::string& date) {
+    std::tm tm = {};
+    std::istringstream ss(date);
+    ss >> std::get_time(&tm, "%Y-%m-%d");
+    return tm;
+}
+std::string legacyAddDays(const std::string& date, int days) {
+    std::tm tm = legacyParse(date);
+    std::time_t time = std::mktime(&tm);
+    time += days * 24 * 60 * 60;
+    std::ostringstream oss;
+    oss << std::put_time(std::localtime(&time), "%Y-%m-%d");
+    return oss.str();
+}
+std::string legacyDayOfWeek(const std::string& date) {
+    std::tm tm = legacyParse(date);
+    std::mktime(&tm);
+    const char* days[] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+    return days[tm.tm_wday];
+}
+
+// ---- Benchmarks ----
+
+// 1024 date strings to cycle through
+std::vector<std::string> sampleDates(const Dataset& data) {
+    std::vector<std::string> dates;
+    for (int day : data.sampleDays) dates.push_back(daysToDate(day));
+    return dates;
+}
+
+void benchTimeToMinutes(State& state, Dataset& data) {
+    std::vector<std::string_view> times;
+    for (size_t i = 0; i < 1024; ++i) times.push_back(data.appointments[i % data.appointments.size()].time);
+    size_t i = 0;
+    int total = 0;
+    while (state.keepRunning()) total += timeToMinutes(times[i++ & 1023]);
+    doNotOptimize(total);
+    state.itemsProcessed = state.iterations;
+}
+
+void benchAppointmentsOverlap(State& state, Dataset& data) {
+    const auto& appointments = data.appointments;
+    size_t count = std::min<size_t>(appointments.size(), 1024);
+    size_t i = 0;
+    size_t overlaps = 0;
+    while (state.keepRunning()) {
+        overlaps += appointmentsOverlap(appointments[i % count], appointments[(i + 1) % count]);
+        ++i;
+    }
+    doNotOptimize(overlaps);
+    state.itemsProcessed = state.iterations;
+}
+
+void benchParseServiceType(State& state, Dataset&) {
+    const std::string_view services[] = {"hair", "haircut", "beard", "full", "both", "45"};
+    size_t i = 0;
+    int kinds = 0;
+    while (state.keepRunning()) kinds += static_cast<int>(parseServiceType(services[i++ % 6]));
+    doNotOptimize(kinds);
+    state.itemsProcessed = state.iterations;
+}
+
+// 100K distinct client names, made of syllables so they share prefixes the way real names do
+const std::vector<std::string>& clientNames() {
+    static const std::vector<std::string> names = [] {
+        const char* syllables[] = {"an", "be", "ca", "de", "el", "fi", "go", "ha", "is", "jo",
+                                   "ka", "li", "ma", "ne", "ol", "pa", "ri", "sa", "to", "vi"};
+        std::mt19937 random(7);
+        std::vector<std::string> list;
+        for (int i = 0; i < 100000; ++i) {
+            std::string name(1, static_cast<char>('A' + random() % 26));
+            for (int s = 2 + static_cast<int>(random() % 3); s > 0; --s) name += syllables[random() % 20];
+            list.push_back(name + std::to_string(i));
+        }
+        return list;
+    }();
+    return names;
+}
+
+// Tab on a one- to three-letter client prefix, any capitalization, with 100K clients
+void benchCompleteClient(State& state, Dataset&) {
+    const auto& names = clientNames();
+    static const PrefixTrie trie = [&names] {
+        PrefixTrie built;
+        for (const auto& name : names) built.insert(name);
+        return built;
+    }();
+    std::vector<std::string> prefixes;
+    for (size_t i = 0; i < 1024; ++i) prefixes.push_back(names[i * 97].substr(0, 1 + i % 3));
+    size_t i = 0;
+    while (state.keepRunning()) doNotOptimize(trie.complete(prefixes[i++ & 1023], 40, true));
+    state.itemsProcessed = state.iterations;
+}
+
+// a client's last appointment deleted and booked again: the trie update add/del do
+void benchUpdateClientTrie(State& state, Dataset&) {
+    const auto& names = clientNames();
+    PrefixTrie trie;
+    for (const auto& name : names) trie.insert(name);
+    size_t i = 0;
+    while (state.keepRunning()) {
+        const std::string& name = names[(i++ * 7919) % names.size()];
+        trie.erase(name);
+        trie.insert(name);
+    }
+    doNotOptimize(trie.size());
+    state.itemsProcessed = state.iterations;
+}
+
+// who gets a freed half hour among 10K waiting clients, each waiting up to four weeks somewhere in a year within
+// hours of their own: the match del and reschedule run inline. The scan is the same match over the whole list
+static WaitlistEntry waitingClient(std::string_view name, std::mt19937& random) {
+    WaitlistEntry entry;
+    entry.request.name = name;
+    entry.request.service = "hair";
+    entry.request.duration = 15 + 15 * static_cast<int>(random() % 3);
+    entry.request.day = static_cast<int>(random() % 365);
+    entry.request.start = 9 * 60 + 60 * static_cast<int>(random() % 6);
+    entry.lastDay = entry.request.day + static_cast<int>(random() % 28);
+    entry.to = entry.request.start + 60 * (1 + static_cast<int>(random() % 4));
+    entry.priority = static_cast<int>(random() % 4);
+    return entry;
+}
+
+template <bool tree>
+void benchWaitlistMatch(State& state, Dataset&) {
+    const auto& names = clientNames();
+    std::mt19937 random(11);
+    Waitlist waitlist;
+    for (size_t i = 0; i < 10000; ++i) waitlist.add(waitingClient(names[i], random));
+    waitlist.match(0, 0, 0, 0, 0, ""); // builds the tree, untimed
+    auto scan = [&waitlist](int day, int start, int end) {
+        size_t best = Waitlist::none;
+        for (size_t i = 0; i < waitlist.size(); ++i) {
+            const WaitlistEntry& entry = waitlist[i];
+            if (day < entry.firstDay() || day > entry.lastDay || entry.startIn(start, end, start) < 0) continue;
+            if (best == Waitlist::none || entry.priority > waitlist[best].priority) best = i;
+        }
+        return best;
+    };
+    size_t i = 0;
+    while (state.keepRunning()) {
+        int day = static_cast<int>((i * 7919) % 365);
+        int start = 9 * 60 + static_cast<int>((i * 37) % 16) * 30;
+        ++i;
+        if constexpr (tree) {
+            doNotOptimize(waitlist.match(day, start, start + 30, start, start + 30, ""));
+        } else {
+            doNotOptimize(scan(day, start, start + 30));
+        }
+    }
+    state.itemsProcessed = state.iterations;
+}
+
+// the same list as clients are backfilled: each freed half hour's match leaves the list and a new client joins it,
+// so the tree is kept up with the changes. The rebuild variant builds it again after every change instead
+template <bool incremental>
+void benchWaitlistBackfill(State& state, Dataset&) {
+    const auto& names = clientNames();
+    std::mt19937 random(11);
+    Waitlist waitlist;
+    size_t joined = 0;
+    for (; joined < 10000; ++joined) waitlist.add(waitingClient(names[joined], random));
+    waitlist.match(0, 0, 0, 0, 0, "");
+    size_t i = 0;
+    while (state.keepRunning()) {
+        int day = static_cast<int>((i * 7919) % 365);
+        int start = 9 * 60 + static_cast<int>((i * 37) % 16) * 30;
+        ++i;
+        size_t found = waitlist.match(day, start, start + 30, start, start + 30, "");
+        if (found == Waitlist::none) continue;
+        waitlist.remove(waitlist[found].joined);
+        waitlist.add(waitingClient(names[joined++ % names.size()], random));
+        if constexpr (!incremental) waitlist.assign(waitlist.entries());
+    }
+    state.itemsProcessed = state.iterations;
+}
+
+void benchFindNextAvailableTime(State& state, Dataset& data) {
+    std::vector<std::string> dates = sampleDates(data);
+    size_t i = 0;
+    while (state.keepRunning()) {
+        std::string time = findNextAvailableTime(data.index, dates[i++ & 1023], 30);
+        doNotOptimize(time);
+    }
+    state.itemsProcessed = state.iterations;
+}
+
+void benchLoadAppointments(State& state, Dataset& data) {
+    const std::string& path = data.textFile();
+    while (state.keepRunning()) {
+        TextArena arena;
+        std::vector<Appointment> appointments;
+        loadAppointments(appointments, path, arena);
+        doNotOptimize(appointments.size());
+    }
+    state.itemsProcessed = state.iterations * data.size;
+    state.bytesProcessed = state.iterations * static_cast<size_t>(std::filesystem::file_size(path));
+}
+
+void benchLegacyLoad(State& state, Dataset& data) {
+    const std::string& path = data.textFile();
+    while (state.keepRunning()) doNotOptimize(legacyLoad(path));
+    state.itemsProcessed = state.iterations * data.size;
+    state.bytesProcessed = state.iterations * static_cast<size_t>(std::filesystem::file_size(path));
+}
+
+void benchSaveAppointments(State& state, Dataset& data) {
+    const std::string path = data.textFile() + ".save";
+    while (state.keepRunning()) saveAppointments(data.appointments, path);
+    state.itemsProcessed = state.iterations * data.size;
+    state.bytesProcessed = state.iterations * static_cast<size_t>(std::filesystem::file_size(path));
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+// time to first prompt with the default 7:90 load window
+void benchStartup(State& state, const std::string& store) {
+    LoadWindow window;
+    window.enabled = true;
+    while (state.keepRunning()) {
+        TextArena arena;
+        std::vector<Appointment> appointments;
+        ScheduleIndex index;
+        DayPager pager;
+        recoverAppointments(appointments, index, pager, store, arena, window, true);
+        doNotOptimize(appointments.size());
+    }
+}
+void benchStartupText(State& state, Dataset& data) { benchStartup(state, data.textFile()); }
+void benchStartupBinary(State& state, Dataset& data) { benchStartup(state, data.binaryFile()); }
+
+// four locations of this size, each loaded in full (what --locations does at startup), one after the other
+// or at the same time on a thread pool
+template <bool parallel>
+void benchStartupLocations(State& state, Dataset& data) {
+    constexpr size_t locations = 4;
+    const std::string& store = data.textFile();
+    LoadWindow window; // whole stores
+    ThreadPool pool(locations);
+    while (state.keepRunning()) {
+        std::vector<size_t> loaded(locations);
+        auto load = [&](size_t i) {
+            TextArena arena;
+            std::vector<Appointment> appointments;
+            ScheduleIndex index;
+            DayPager pager;
+            recoverAppointments(appointments, index, pager, store, arena, window, true);
+            loaded[i] = appointments.size();
+        };
+        if (parallel) {
+            pool.forEach(locations, load);
+        } else {
+            for (size_t i = 0; i < locations; ++i) load(i);
+        }
+        doNotOptimize(loaded);
+    }
+    state.itemsProcessed = state.iterations * data.size * locations;
+}
+
+// the whole store loaded as the prompt holds it (appointments, schedule index and client index), for what that
+// costs: allocations per load, and the heap in use and the process's growth in resident size while it is held
+void benchMemory(State& state, const std::string& store, size_t records) {
+    struct Loaded {
+        TextArena arena;
+        std::vector<Appointment> appointments;
+        ScheduleIndex index;
+        DayPager pager;
+        ClientIndex clients;
+    };
+    auto grown = [](size_t after, size_t before) { return after > before ? after - before : 0; };
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        trimHeap();
+        size_t heapBefore = heapInUse(), residentBefore = residentBytes();
+        state.resumeTiming();
+        auto loaded = std::make_unique<Loaded>();
+        recoverAppointments(loaded->appointments, loaded->index, loaded->pager, store, loaded->arena, LoadWindow(), true);
+        for (size_t i = 0; i < loaded->appointments.size(); ++i) loaded->clients.insert(loaded->appointments[i].name, i);
+        state.pauseTiming();
+        state.heapBytes = std::max(state.heapBytes, grown(heapInUse(), heapBefore));
+        state.residentBytes = std::max(state.residentBytes, grown(residentBytes(), residentBefore));
+        loaded.reset(); // not timed
+        state.resumeTiming();
+    }
+    state.itemsProcessed = state.iterations * records;
+}
+void benchMemoryText(State& state, Dataset& data) { benchMemory(state, data.textFile(), data.size); }
+void benchMemoryBinary(State& state, Dataset& data) { benchMemory(state, data.binaryFile(), data.size); }
+
+// a year's report from a sample day on, or the report over the whole store
+template <bool wholeStore, bool parallel>
+void benchReport(State& state, Dataset& data) {
+    ThreadPool pool;
+    std::vector<RecurrenceRule> rules;
+    size_t i = 0;
+    while (state.keepRunning()) {
+        int first = wholeStore ? data.firstDay : data.sampleDays[i++ & 1023];
+        int last = wholeStore ? data.lastDay : first + 364;
+        ScheduleReport report = buildReport(data.appointments, data.index, rules, shopConfig(), first, last, parallel ? &pool : nullptr);
+        doNotOptimize(report);
+        state.itemsProcessed += static_cast<size_t>(report.appointments());
+    }
+}
+
+void benchDisplayDaily(State& state, Dataset& data) {
+    std::vector<std::string> dates = sampleDates(data);
+    Frame frame;
+    size_t i = 0;
+    while (state.keepRunning()) {
+        displayDailySchedule(frame, data.appointments, data.index, dates[i++ & 1023]);
+        state.bytesProcessed += frame.str().size();
+        frame.clear();
+    }
+}
+
+void benchDisplayWeekly(State& state, Dataset& data) {
+    std::vector<std::string> weeks;
+    for (int day : data.sampleDays) weeks.push_back(daysToDate(weekStartFromDays(day)));
+    Frame frame;
+    size_t i = 0;
+    while (state.keepRunning()) {
+        displayWeeklySchedule(frame, data.appointments, data.index, weeks[i++ & 1023]);
+        state.bytesProcessed += frame.str().size();
+        frame.clear();
+    }
+}
+
+void benchDisplayMonthly(State& state, Dataset& data) {
+    std::vector<int> months;
+    for (int day : data.sampleDays) {
+        CivilDate date = civilFromDays(day);
+        months.push_back(daysFromCivil(date.year, date.month, 1));
+    }
+    Frame frame;
+    size_t i = 0;
+    while (state.keepRunning()) {
+        displayMonthlySchedule(frame, data.index, months[i++ & 1023]);
+        state.bytesProcessed += frame.str().size();
+        frame.clear();
+    }
+}
+
+template <std::string (*Op)(const std::string&)>
+void benchDateHelper(State& state, Dataset& data) {
+    std::vector<std::string> dates = sampleDates(data);
+    size_t i = 0;
+    while (state.keepRunning()) doNotOptimize(Op(dates[i++ & 1023]));
+    state.itemsProcessed = state.iterations;
+}
+std::string nextDate(const std::string& date) { return getNextDate(date); }
+std::string legacyNextDate(const std::string& date) { return legacyAddDays(date, 1); }
+std::string dayOfWeek(const std::string& date) { return std::string(getDayOfWeek(date)); }
+
+struct Benchmark {
+    const char* name;
+    void (*run)(State&, Dataset&);
+    TimeUnit unit;
+    bool sized; // runs once per dataset size; otherwise once, on the smallest dataset
+};
+
+const Benchmark benchmarks[] = {
+    {"timeToMinutes", benchTimeToMinutes, TimeUnit::ns, false},
+    {"appointmentsOverlap", benchAppointmentsOverlap, TimeUnit::ns, false},
+    {"parseServiceType", benchParseServiceType, TimeUnit::ns, false},
+    {"completeClient/100K", benchCompleteClient, TimeUnit::ns, false},
+    {"updateClientTrie/100K", benchUpdateClientTrie, TimeUnit::ns, false},
+    {"waitlistMatch/10K", benchWaitlistMatch<true>, TimeUnit::ns, false},
+    {"waitlistMatch/10K/scan", benchWaitlistMatch<false>, TimeUnit::ns, false},
+    {"waitlistBackfill/10K", benchWaitlistBackfill<true>, TimeUnit::ns, false},
+    {"waitlistBackfill/10K/rebuild", benchWaitlistBackfill<false>, TimeUnit::ns, false},
+    {"getNextDate", benchDateHelper<nextDate>, TimeUnit::ns, false},
+    {"legacy/getNextDate", benchDateHelper<legacyNextDate>, TimeUnit::ns, false},
+    {"getDayOfWeek", benchDateHelper<dayOfWeek>, TimeUnit::ns, false},
+    {"legacy/getDayOfWeek", benchDateHelper<legacyDayOfWeek>, TimeUnit::ns, false},
+    {"findNextAvailableTime", benchFindNextAvailableTime, TimeUnit::ns, true},
+    {"loadAppointments", benchLoadAppointments, TimeUnit::ms, true},
+    {"legacy/loadAppointments", benchLegacyLoad, TimeUnit::ms, true},
+    {"saveAppointments", benchSaveAppointments, TimeUnit::ms, true},
+    {"startup/text", benchStartupText, TimeUnit::ms, true},
+    {"startup/binary", benchStartupBinary, TimeUnit::ms, true},
+    {"startup/4locations/sequential", benchStartupLocations<false>, TimeUnit::ms, true},
+    {"startup/4locations/pool", benchStartupLocations<true>, TimeUnit::ms, true},
+    {"memory/text", benchMemoryText, TimeUnit::ms, true},
+    {"memory/binary", benchMemoryBinary, TimeUnit::ms, true},
+    {"report/year", benchReport<false, true>, TimeUnit::us, true},
+    {"report/all/sequential", benchReport<true, false>, TimeUnit::ms, true},
+    {"report/all/pool", benchReport<true, true>, TimeUnit::ms, true},
+    {"displayDailySchedule", benchDisplayDaily, TimeUnit::us, true},
+    {"displayWeeklySchedule", benchDisplayWeekly, TimeUnit::us, true},
+    {"displayMonthlySchedule", benchDisplayMonthly, TimeUnit::us, true},
+};
+
+struct Result {
+    std::string name;
+    size_t iterations;
+    double realTime; // per iteration, in unit
+    double cpuTime;
+    TimeUnit unit;
+    double itemsPerSecond;
+    double bytesPerSecond;
+    double allocsPerIteration;
+    size_t heapBytes;
+    size_t residentBytes;
+};
+
+const char* unitName(TimeUnit unit) {
+    return unit == TimeUnit::ns ? "ns" : unit == TimeUnit::us ? "us" : "ms";
+}
+
+double unitScale(TimeUnit unit) {
+    return unit == TimeUnit::ns ? 1e9 : unit == TimeUnit::us ? 1e6 : 1e3;
+}
+
+// Run one benchmark, growing the iteration count until a run lasts at least minTime (like Google Benchmark)
+Result runBenchmark(const Benchmark& benchmark, const std::string& name, Dataset& data, double minTime) {
+    size_t iterations = 1;
+    while (true) {
+        State state(benchmark.sized ? data.size : 0, iterations);
+        benchmark.run(state, data);
+        bool done = state.realSeconds >= minTime || iterations >= 1000000000;
+        if (done) {
+            double scale = unitScale(benchmark.unit) / static_cast<double>(iterations);
+            double seconds = std::max(state.realSeconds, 1e-12);
+            return Result{name, iterations, state.realSeconds * scale, state.cpuSeconds * scale, benchmark.unit,
+                          state.itemsProcessed / seconds, state.bytesProcessed / seconds,
+                          static_cast<double>(state.allocations) / static_cast<double>(iterations),
+                          state.heapBytes, state.residentBytes};
+        }
+        double grow = state.realSeconds > 0 ? minTime * 1.4 / state.realSeconds : 10; // aim a bit past minTime
+        iterations = static_cast<size_t>(static_cast<double>(iterations) * std::min(10.0, std::max(2.0, grow)));
+    }
+}
+
+// "1.23M/s"-style rate for the console
+std::string humanRate(double perSecond, const char* suffix) {
+    const char* prefixes[] = {"", "k", "M", "G", "T"};
+    int prefix = 0;
+    while (perSecond >= 1000 && prefix < 4) {
+        perSecond /= 1000;
+        ++prefix;
+    }
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(perSecond < 10 ? 2 : perSecond < 100 ? 1 : 0) << perSecond << prefixes[prefix] << suffix;
+    return text.str();
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+    }
+    return escaped;
+}
+
+// Google Benchmark's JSON layout: a context object and one entry per run
+std::string toJson(const std::vector<Result>& results, const std::string& executable) {
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    std::ostringstream json;
+    json << std::setprecision(10);
+    json << "{\n  \"context\": {\n"
+         << "    \"date\": \"" << date << "\",\n"
+         << "    \"executable\": \"" << jsonEscape(executable) << "\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+         << "    \"library_build_type\": \"release\"\n"
+#else
+         << "    \"library_build_type\": \"debug\"\n"
+#endif
+         << "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        json << (i ? "," : "") << "\n    {\n"
+             << "      \"name\": \"" << jsonEscape(r.name) << "\",\n"
+             << "      \"run_name\": \"" << jsonEscape(r.name) << "\",\n"
+             << "      \"run_type\": \"iteration\",\n"
+             << "      \"repetitions\": 1,\n"
+             << "      \"repetition_index\": 0,\n"
+             << "      \"threads\": 1,\n"
+             << "      \"iterations\": " << r.iterations << ",\n"
+             << "      \"real_time\": " << r.realTime << ",\n"
+             << "      \"cpu_time\": " << r.cpuTime << ",\n"
+             << "      \"time_unit\": \"" << unitName(r.unit) << "\",\n"
+             << "      \"allocs_per_iter\": " << r.allocsPerIteration;
+        if (r.itemsPerSecond > 0) json << ",\n      \"items_per_second\": " << r.itemsPerSecond;
+        if (r.bytesPerSecond > 0) json << ",\n      \"bytes_per_second\": " << r.bytesPerSecond;
+        if (r.heapBytes > 0) json << ",\n      \"heap_bytes\": " << r.heapBytes;
+        if (r.residentBytes > 0) json << ",\n      \"resident_bytes\": " << r.residentBytes;
+        json << "\n    }";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+}
+
+void printConsoleRow(const Result& r) {
+    std::cout << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(13) << r.realTime << " " << std::setw(2) << unitName(r.unit)
+              << std::setw(13) << r.cpuTime << " " << std::setw(2) << unitName(r.unit)
+              << std::setw(12) << r.iterations;
+    if (r.itemsPerSecond > 0) std::cout << " items_per_second=" << humanRate(r.itemsPerSecond, "/s");
+    if (r.bytesPerSecond > 0) std::cout << " bytes_per_second=" << humanRate(r.bytesPerSecond, "B/s");
+    if (r.allocsPerIteration > 0) std::cout << " allocs_per_iter=" << humanRate(r.allocsPerIteration, "");
+    if (r.heapBytes > 0) std::cout << " heap=" << humanRate(static_cast<double>(r.heapBytes), "B");
+    if (r.residentBytes > 0) std::cout << " resident=" << humanRate(static_cast<double>(r.residentBytes), "B");
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter, format = "console", outPath;
+    double minTime = 0.5;
+    size_t maxRecords = 10000000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string option = arg.substr(0, eq), value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (option == "--benchmark_filter") {
+            filter = value;
+        } else if (option == "--benchmark_min_time") {
+            minTime = std::stod(value);
+        } else if (option == "--benchmark_format" && (value == "console" || value == "json")) {
+            format = value;
+        } else if (option == "--benchmark_out") {
+            outPath = value;
+        } else if (option == "--max_records") {
+            maxRecords = std::stoul(value);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>]"
+                      << " [--benchmark_format=console|json] [--benchmark_out=<file.json>] [--max_records=<n>]" << std::endl;
+            return 1;
+        }
+    }
+    std::regex pattern(filter.empty() ? "." : filter);
+    bool console = format == "console";
+
+    if (console) {
+        std::cout << "Run on " << std::thread::hardware_concurrency() << " CPUs, datasets of 1000 to "
+                  << maxRecords << " appointments" << std::endl;
+        std::cout << std::string(100, '-') << std::endl;
+        std::cout << std::left << std::setw(40) << "Benchmark" << std::right << std::setw(16) << "Time"
+                  << std::setw(16) << "CPU" << std::setw(12) << "Iterations" << " UserCounters..." << std::endl;
+        std::cout << std::string(100, '-') << std::endl;
+    }
+
+    // one dataset in memory at a time (10M appointments is a couple of GB), every benchmark run against it
+    std::vector<Result> results;
+    for (size_t records = 1000; records <= maxRecords; records *= 10) {
+        bool smallest = records == 1000;
+        std::vector<std::pair<const Benchmark*, std::string>> due;
+        for (const auto& benchmark : benchmarks) {
+            if (!benchmark.sized && !smallest) continue;
+            std::string name = benchmark.sized ? std::string(benchmark.name) + "/" + std::to_string(records) : benchmark.name;
+            if (std::regex_search(name, pattern)) due.push_back({&benchmark, name});
+        }
+        if (due.empty()) continue;
+
+        Dataset data(records);
+        for (const auto& run : due) {
+            results.push_back(runBenchmark(*run.first, run.second, data, minTime));
+            if (console) printConsoleRow(results.back());
+        }
+    }
+
+    std::string json = toJson(results, argv[0]);
+    if (!console) std::cout << json;
+    if (!outPath.empty()) {
+        std::ofstream out(outPath);
+        out << json;
+        if (!out) {
+            std::cerr << "Error: Could not write " << outPath << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include "appointment.h"
+
+#include "calendar.h"
+#include "config.h"
+
+#include <stdexcept>
+
+int parseServiceDuration(const std::string& service) {
+    if (const auto* known = shopConfig().services.find(service)) return known->duration;
+    
+    // Try to parse as number
+     try {
+        return std::stoi(service);
+    } catch (...) {
+        return -1; // Invalid
+    }
+}
+
+ServiceType parseServiceType(std::string_view service) {
+    const auto* known = shopConfig().services.find(service);
+    return known ? known->kind : ServiceType::custom;
+}
+
+void normalizeAppointment(Appointment& apt) {
+    apt.start = timeToMinutes(apt.time);
+    apt.day = dateToDays(apt.date);
+    apt.kind = parseServiceType(apt.service);
+}
+
+bool appointmentsOverlap(const Appointment& a, const Appointment& b) {
+    if (a.day != b.day || a.resource != b.resource) return false;
+    
+    int aEnd = a.start + a.duration; // calculate end time
+    int bEnd = b.start + b.duration; // calculate end time
+    
+    return (a.start < bEnd && aEnd > b.start); // checks for overlap
+}
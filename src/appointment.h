@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+ // Known service types, so comparisons don't go through the service string
+enum class ServiceType : unsigned char {
+    hair,   // hair/haircut
+    beard,  // beard
+    full,   // full/both
+    custom  // duration given in minutes
+};
+
+ struct Appointment { // Structure to hold appointment details (text fields point into a TextArena)
+     std::string_view name;     //client name
+     std::string_view time;     //appointment time (e.g., "10:00") - kept as typed, for display
+     std::string_view date;     //appointment date (YYYY-MM-DD) - kept as typed, for display
+     std::string_view service;  //service type (hair, beard, full) - kept as typed, for display
+     std::string_view resource; //chair/barber it is booked on (empty = the shop's first one)
+     int duration;         //duration in minutes
+     int start = 0;        //time as minutes since midnight, filled in by normalizeAppointment
+     int day = 0;          //date as days since 1970-01-01, filled in by normalizeAppointment
+     ServiceType kind = ServiceType::custom; //service as an enum, filled in by normalizeAppointment
+ };
+
+// Allows strings like "hair"/"beard"/"full"/"both"  to be converted to duration in minutes
+// (looked up in the configured service catalog, see config.h); a number is taken as minutes, -1 if invalid
+int parseServiceDuration(const std::string& service);
+
+// Map a service string to its ServiceType (anything that isn't in the catalog is custom)
+ServiceType parseServiceType(std::string_view service);
+
+// Parse the text fields of an appointment into start/day/kind, once, when it is loaded or edited
+// throws std::invalid_argument on a bad time or date
+void normalizeAppointment(Appointment& apt);
+
+// check if two appointments overlap with eachother to prevent double booking (on the same chair)
+bool appointmentsOverlap(const Appointment& a, const Appointment& b);
@@ -0,0 +1,173 @@
+#include "calendar.h"
+
+#include <charconv>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <cctype>
+
+std::string daysToDate(int days) {
+    CivilDate date = civilFromDays(days);
+    char text[10];
+    writeDigits(text, date.year, 4);
+    text[4] = '-';
+    writeDigits(text + 5, date.month, 2);
+    text[7] = '-';
+    writeDigits(text + 8, date.day, 2);
+    return std::string(text, sizeof(text));
+}
+
+int dateToDays(std::string_view date) {
+    int y = 0, m = 0, d = 0;
+    const char* end = date.data() + date.size();
+    auto year = std::from_chars(date.data(), end, y);
+    bool ok = year.ec == std::errc() && year.ptr != end && *year.ptr == '-';
+    if (ok) {
+        auto month = std::from_chars(year.ptr + 1, end, m);
+        ok = month.ec == std::errc() && month.ptr != end && *month.ptr == '-';
+        if (ok) {
+            auto dayOfMonth = std::from_chars(month.ptr + 1, end, d);
+            ok = dayOfMonth.ec == std::errc() && dayOfMonth.ptr == end;
+        }
+    }
+    if (!ok || m < 1 || m > 12 || d < 1 || d > 31) {
+        throw std::invalid_argument("Invalid date '" + std::string(date) + "' (use YYYY-MM-DD)");
+    }
+    return daysFromCivil(y, m, d);
+}
+
+std::tm localNow() {
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    return local;
+}
+
+int getCurrentDay() {
+    std::tm now = localNow();
+    return daysFromCivil(now.tm_year + 1900, now.tm_mon + 1, now.tm_mday);
+}
+
+std::string getCurrentDate() {
+    return daysToDate(getCurrentDay());
+}
+
+std::string formatDateDisplay(std::string_view date) {
+    CivilDate civil = civilFromDays(dateToDays(date));
+    char text[8];
+    writeDigits(text, civil.month, 2);
+    text[2] = '-';
+    writeDigits(text + 3, civil.day, 2);
+    text[5] = '-';
+    writeDigits(text + 6, ((civil.year % 100) + 100) % 100, 2);
+    return std::string(text, sizeof(text));
+}
+
+std::string getNextDate(std::string_view date) {
+    return daysToDate(dateToDays(date) + 1);
+}
+
+std::string addDaysToDate(std::string_view date, int days) {
+    return daysToDate(dateToDays(date) + days);
+}
+
+std::string_view dayOfWeekName(int days) {
+    static constexpr std::string_view names[] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+    return names[weekdayFromDays(days)];
+}
+
+std::string_view getDayOfWeek(std::string_view date) {
+    return dayOfWeekName(dateToDays(date));
+}
+
+std::string getWeekStart() {
+    return daysToDate(weekStartFromDays(getCurrentDay()));
+}
+
+int parseWeekday(std::string_view text) {
+    static constexpr std::string_view names[] = {"sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday"};
+    if (text.size() < 3) return -1;
+    for (int weekday = 0; weekday < 7; ++weekday) {
+        std::string_view name = names[weekday];
+        if (text.size() > name.size()) continue;
+        bool same = true;
+        for (size_t i = 0; i < text.size() && same; ++i) {
+            same = (text[i] | 0x20) == name[i]; // ASCII lowercase
+        }
+        if (same) return weekday;
+    }
+    return -1;
+}
+
+int timeToMinutes(std::string_view timeStr) {
+    std::string_view time = timeStr;
+    bool isPM = false;
+    char cleaned[16];
+    
+    // Check for am/pm and cleans the string (keeps only digits and ':')
+    bool hasPM = time.find("pm") != std::string_view::npos || time.find("PM") != std::string_view::npos;
+    bool hasAM = time.find("am") != std::string_view::npos || time.find("AM") != std::string_view::npos;
+    if (hasPM || hasAM) {
+        isPM = hasPM;
+        size_t length = 0;
+        for (char c : timeStr) {
+            if (!std::isdigit(static_cast<unsigned char>(c)) && c != ':') continue;
+            if (length == sizeof(cleaned)) throw std::invalid_argument("Invalid time '" + std::string(timeStr) + "'");
+            cleaned[length++] = c;
+        }
+        time = std::string_view(cleaned, length);
+    }
+    
+    // read the leading number of a piece of the time, like std::stoi would
+    auto leadingInt = [&timeStr](std::string_view part) {
+        while (!part.empty() && std::isspace(static_cast<unsigned char>(part.front()))) part.remove_prefix(1);
+        int value = 0;
+        if (std::from_chars(part.data(), part.data() + part.size(), value).ec != std::errc()) {
+            throw std::invalid_argument("Invalid time '" + std::string(timeStr) + "'");
+        }
+        return value;
+    };
+    
+    int hours = 0, minutes = 0;
+    size_t colonPos = time.find(':');
+    if (colonPos != std::string_view::npos) {
+        hours = leadingInt(time.substr(0, colonPos));
+        minutes = leadingInt(time.substr(colonPos + 1));
+    } else {
+        hours = leadingInt(time);
+    }
+    
+    if (isPM && hours != 12) hours += 12;
+    if (!isPM && hours == 12) hours = 0;
+    
+    return hours * 60 + minutes;
+}
+
+std::string minutesToTime(int minutes) {
+    int hours = minutes / 60;
+    int mins = minutes % 60;
+    std::string period = (hours >= 12) ? "pm" : "am"; // Determine am/pm based on hours
+    if (hours > 12) hours -= 12;
+    if (hours == 0) hours = 12;
+    
+    std::ostringstream oss;
+    oss << hours;  //
+    if (mins > 0) oss << ":" << std::setfill('0') << std::setw(2) << mins; // appends minutes with leading zero if needed
+    oss << period; // append am/pm
+    return oss.str();
+}
+
+int getCurrentTimeInMinutes() {
+    std::tm now = localNow();
+    return now.tm_hour * 60 + now.tm_min;
+}
+
+int currentMonthNumber() {
+    CivilDate today = civilFromDays(getCurrentDay());
+    return today.year * 12 + (today.month - 1);
+}
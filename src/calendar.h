@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <ctime>
+
+// ---- Calendar arithmetic ----
+// Dates are handled as day numbers (days since 1970-01-01) using Howard Hinnant's civil-date algorithms,
+// so adding days, weekdays and week starts are plain integer math: no mktime/localtime round-trips,
+// no heap allocations, and no DST surprises from adding 24*60*60 seconds
+
+// A calendar date split into its parts
+struct CivilDate {
+    int year;
+    int month; // 1-12
+    int day;   // 1-31
+};
+
+// Days since 1970-01-01 for a Gregorian year/month/day (days_from_civil)
+constexpr int daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;                                  // [0, 399]
+    const int doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1; // [0, 365]
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;          // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+// Inverse of daysFromCivil (civil_from_days)
+constexpr CivilDate civilFromDays(int days) {
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const int doe = days - era * 146097;                                   // [0, 146096]
+    const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
+    const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);              // [0, 365]
+    const int mp = (5 * doy + 2) / 153;                                    // [0, 11]
+    const int d = doy - (153 * mp + 2) / 5 + 1;                            // [1, 31]
+    const int m = mp < 10 ? mp + 3 : mp - 9;                               // [1, 12]
+    return CivilDate{yoe + era * 400 + (m <= 2), m, d};
+}
+
+// Day of week for a day number, 0 = Sunday ... 6 = Saturday (1970-01-01 was a Thursday)
+constexpr int weekdayFromDays(int days) {
+    return days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6;
+}
+
+// Day number of the Monday starting the week that contains days
+constexpr int weekStartFromDays(int days) {
+    return days - (weekdayFromDays(days) + 6) % 7;
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "calendar epoch");
+static_assert(civilFromDays(daysFromCivil(2024, 2, 29)).day == 29, "leap day round-trip");
+static_assert(weekdayFromDays(daysFromCivil(2025, 12, 1)) == 1, "2025-12-01 is a Monday");
+static_assert(weekStartFromDays(daysFromCivil(2025, 11, 30)) == daysFromCivil(2025, 11, 24), "Sunday belongs to the week before");
+
+// Write value as exactly width zero-padded digits
+constexpr void writeDigits(char* out, int value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// Day number back to "YYYY-MM-DD" (short enough for the small-string buffer, so no heap allocation)
+std::string daysToDate(int days);
+
+// Convert YYYY-MM-DD to days since 1970-01-01, so dates compare and bucket as plain ints
+int dateToDays(std::string_view date);
+
+// The current local time, broken down. Uses the reentrant localtime, since the daemon asks from many threads
+std::tm localNow();
+
+// Today's day number in local time
+int getCurrentDay();
+
+// Get current date as YYYY-MM-DD format
+std::string getCurrentDate();
+
+// Converts date from YYYY-MM-DD to MM-DD-YY format (personal preference)
+std::string formatDateDisplay(std::string_view date);
+
+// Get next day's date as YYYY-MM-DD string
+std::string getNextDate(std::string_view date);
+
+// Add days to a date
+std::string addDaysToDate(std::string_view date, int days);
+
+// Day of week name for a day number
+std::string_view dayOfWeekName(int days);
+
+// Get day of week name
+std::string_view getDayOfWeek(std::string_view date);
+
+// Get start of current week (Monday)
+std::string getWeekStart();
+
+// Weekday from its name or its first three letters ("tue", "Tuesday"), 0 = Sunday ... 6 = Saturday; -1 if it isn't one
+int parseWeekday(std::string_view text);
+
+// Convert time string (e.g., "10am" or "10:30") to minutes since midnight, for easy comparison/calculation - needed for overlap checks
+// Parses on the stack without allocating; throws std::invalid_argument if there is no number to read
+int timeToMinutes(std::string_view timeStr);
+
+// Convert minutes since midnight to time string (e.g. "10am" or "10:30" 
+std::string minutesToTime(int minutes);
+
+// Get current time in minutes since midnight
+int getCurrentTimeInMinutes();
+
+// The current month as months since year 0
+int currentMonthNumber();
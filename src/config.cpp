@@ -0,0 +1,261 @@
+#include "config.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+// the three built-in services keep their colors, under any of their names
+static ServiceType builtinKind(std::string_view name) {
+    if (name == "hair" || name == "haircut") return ServiceType::hair;
+    if (name == "beard") return ServiceType::beard;
+    if (name == "full" || name == "both") return ServiceType::full;
+    return ServiceType::custom;
+}
+
+void ServiceCatalog::add(const std::string& name, int duration, const std::vector<std::string>& aliases) {
+    ServiceType kind = builtinKind(name);
+    for (const auto& alias : aliases) {
+        if (kind == ServiceType::custom) kind = builtinKind(alias);
+    }
+    services.push_back(Service{name, duration, kind, false, 0});
+    for (const auto& alias : aliases) services.push_back(Service{alias, duration, kind, true, 0});
+}
+
+bool ServiceCatalog::setPrice(std::string_view name, int cents) {
+    auto named = std::find_if(services.begin(), services.end(), [name](const Service& s) { return s.name == name; });
+    if (named == services.end()) return false;
+    auto first = named;
+    while (first->alias) --first; // aliases follow the service they name
+    first->price = cents;
+    for (auto alias = first + 1; alias != services.end() && alias->alias; ++alias) alias->price = cents;
+    return true;
+}
+
+void ServiceCatalog::compile() {
+    table.clear();
+    if (services.empty()) return;
+    shortestDuration = std::min_element(services.begin(), services.end(), [](const Service& a, const Service& b) {
+        return a.duration < b.duration;
+    })->duration;
+    size_t size = 8;
+    while (size < services.size() * 2) size *= 2;
+    while (true) {
+        mask = static_cast<std::uint32_t>(size - 1);
+        for (seed = 0; seed < 1000; ++seed) { // a handful of tries is typical at half load
+            table.assign(size, -1);
+            bool collision = false;
+            for (size_t i = 0; i < services.size() && !collision; ++i) {
+                std::int16_t& cell = table[hash(services[i].name, seed) & mask];
+                if (cell >= 0) collision = true;
+                cell = static_cast<std::int16_t>(i);
+            }
+            if (!collision) return;
+        }
+        size *= 2;
+    }
+}
+
+std::string ServiceCatalog::describe() const {
+    std::string text;
+    for (const auto& service : services) {
+        if (service.alias) continue;
+        if (!text.empty()) text += ", ";
+        text += "'" + service.name + "' (" + std::to_string(service.duration) + " min)";
+    }
+    return text;
+}
+
+void ShopConfig::compileHours(const std::array<std::vector<std::pair<int, int>>, 7>& hours,
+                              const std::array<std::vector<std::pair<int, int>>, 7>& breaks) {
+    for (int weekday = 0; weekday < 7; ++weekday) {
+        DayHours& day = week[weekday];
+        day = DayHours();
+        for (const auto& range : hours[weekday]) {
+            for (int m = range.first; m < range.second; ++m) day.open.set(m);
+        }
+        for (const auto& range : breaks[weekday]) {
+            for (int m = range.first; m < range.second; ++m) day.open.reset(m);
+        }
+        for (int m = 0; m < minutesPerDay; ++m) { // the bitmap's set stretches, in order
+            if (!day.open[m]) continue;
+            int start = m;
+            while (m < minutesPerDay && day.open[m]) ++m;
+            day.runs.push_back({start, m});
+        }
+        if (day.runs.empty()) continue;
+        day.opens = day.runs.front().first;
+        day.closes = day.runs.back().second;
+        day.overrideRuns = day.runs;
+        day.overrideRuns.back().second = std::max(day.closes, overrideEnd);
+    }
+}
+
+ShopConfig ShopConfig::defaults() {
+    ShopConfig config;
+    std::array<std::vector<std::pair<int, int>>, 7> hours, breaks;
+    for (auto& day : hours) day.push_back({10 * 60, 18 * 60});
+    config.compileHours(hours, breaks);
+    config.services.add("hair", 30, {"haircut"});
+    config.services.add("beard", 15);
+    config.services.add("full", 45, {"both"});
+    config.services.compile();
+    return config;
+}
+
+// "mon", "mon-fri", "fri-mon", "mon,wed,fri" or "daily" as a set of weekdays; empty if it isn't one
+static std::array<bool, 7> parseDays(std::string_view text) {
+    std::array<bool, 7> days{};
+    if (text == "daily" || text == "all") {
+        days.fill(true);
+        return days;
+    }
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view part = text.substr(0, comma);
+        size_t dash = part.find('-');
+        int first = parseWeekday(part.substr(0, dash));
+        int last = dash == std::string_view::npos ? first : parseWeekday(part.substr(dash + 1));
+        if (first < 0 || last < 0) return {};
+        for (int d = first;; d = (d + 1) % 7) {
+            days[d] = true;
+            if (d == last) break;
+        }
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+    }
+    return days;
+}
+
+// "25", "37.5" or "37.50" (a leading '$' is allowed) in cents; throws std::invalid_argument if it isn't an amount
+static int parseAmount(std::string_view text) {
+    if (!text.empty() && text[0] == '$') text.remove_prefix(1);
+    size_t dot = text.find('.');
+    std::string_view whole = text.substr(0, dot);
+    std::string_view cents = dot == std::string_view::npos ? std::string_view() : text.substr(dot + 1);
+    auto digits = [](std::string_view part) {
+        return std::all_of(part.begin(), part.end(), [](char c) { return c >= '0' && c <= '9'; });
+    };
+    if (whole.empty() || whole.size() > 7 || !digits(whole) || (dot != std::string_view::npos && (cents.empty() || cents.size() > 2 || !digits(cents)))) {
+        throw std::invalid_argument("'" + std::string(text) + "' is not an amount like 25 or 37.50");
+    }
+    int amount = std::stoi(std::string(whole)) * 100;
+    if (!cents.empty()) amount += std::stoi(std::string(cents)) * (cents.size() == 1 ? 10 : 1);
+    return amount;
+}
+
+// "10am-6pm" or "13:00-13:30" as [from, to) in minutes; throws std::invalid_argument if it isn't a range
+static std::pair<int, int> parseRange(std::string_view text) {
+    size_t dash = text.find('-');
+    if (dash == std::string_view::npos) throw std::invalid_argument("expected a range like 10am-6pm");
+    int from = timeToMinutes(text.substr(0, dash));
+    int to = timeToMinutes(text.substr(dash + 1));
+    if (from < 0 || to > minutesPerDay || to <= from) throw std::invalid_argument("'" + std::string(text) + "' is not a range within one day");
+    return {from, to};
+}
+
+bool ShopConfig::load(const std::string& path, ShopConfig& config, bool optional) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        if (optional) return true;
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return false;
+    }
+
+    std::array<std::vector<std::pair<int, int>>, 7> hours, breaks;
+    for (auto& day : hours) day.push_back({10 * 60, 18 * 60});
+    ServiceCatalog services;
+    bool servicesGiven = false;
+    std::vector<std::string> names;
+    struct Price { std::string service; int cents; int line; };
+    std::vector<Price> prices; // set once the catalog is known
+    int lineNumber = 0;
+    for (std::string line; std::getline(file, line);) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        std::istringstream iss(line);
+        std::string key;
+        if (!(iss >> key)) continue; // blank or comment
+        try {
+            if (key == "hours" || key == "break") {
+                std::string daysText, rangeText;
+                if (!(iss >> daysText >> rangeText)) throw std::invalid_argument("expected " + key + " <days> <from>-<to>");
+                std::array<bool, 7> days = parseDays(daysText);
+                if (std::none_of(days.begin(), days.end(), [](bool d) { return d; })) {
+                    throw std::invalid_argument("'" + daysText + "' is not a day, a range of days (mon-fri) or 'daily'");
+                }
+                bool closed = key == "hours" && rangeText == "closed";
+                std::pair<int, int> range = closed ? std::pair<int, int>() : parseRange(rangeText);
+                for (int d = 0; d < 7; ++d) {
+                    if (!days[d]) continue;
+                    if (key == "break") {
+                        breaks[d].push_back(range);
+                    } else {
+                        hours[d].clear(); // the last hours line for a day wins
+                        if (!closed) hours[d].push_back(range);
+                    }
+                }
+            } else if (key == "override") {
+                std::string end;
+                if (!(iss >> end)) throw std::invalid_argument("expected override <time>");
+                config.overrideEnd = timeToMinutes(end);
+                if (config.overrideEnd <= 0 || config.overrideEnd > minutesPerDay) throw std::invalid_argument("invalid override time");
+            } else if (key == "interval") {
+                if (!(iss >> config.interval) || config.interval <= 0 || config.interval > 240) {
+                    throw std::invalid_argument("expected interval <minutes> (1-240)");
+                }
+            } else if (key == "service") {
+                std::string name;
+                int duration = 0;
+                if (!(iss >> name >> duration) || duration <= 0) throw std::invalid_argument("expected service <name> <minutes> [alias...]");
+                std::vector<std::string> aliases;
+                for (std::string alias; iss >> alias;) aliases.push_back(alias);
+                for (const auto& each : aliases) names.push_back(each);
+                names.push_back(name);
+                servicesGiven = true;
+                services.add(name, duration, aliases);
+            } else if (key == "price") {
+                std::string name, amount;
+                if (!(iss >> name >> amount)) throw std::invalid_argument("expected price <service> <amount>");
+                prices.push_back({name, parseAmount(amount), lineNumber});
+            } else {
+                throw std::invalid_argument("unknown setting '" + key + "'");
+            }
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Error: " << path << " line " << lineNumber << ": " << e.what() << std::endl;
+            return false;
+        }
+    }
+    std::sort(names.begin(), names.end());
+    auto duplicate = std::adjacent_find(names.begin(), names.end());
+    if (duplicate != names.end()) {
+        std::cerr << "Error: " << path << ": service '" << *duplicate << "' is defined twice" << std::endl;
+        return false;
+    }
+
+    config.compileHours(hours, breaks);
+    if (servicesGiven) { // a catalog replaces the built-in one
+        config.services = std::move(services);
+        config.services.compile();
+    }
+    for (const auto& price : prices) { // a price may come before the service line it is for
+        if (!config.services.setPrice(price.service, price.cents)) {
+            std::cerr << "Error: " << path << " line " << price.line << ": price for unknown service '" << price.service << "'" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static ShopConfig& installedConfig() {
+    static ShopConfig config = ShopConfig::defaults();
+    return config;
+}
+
+const ShopConfig& shopConfig() {
+    return installedConfig();
+}
+
+void setShopConfig(ShopConfig config) {
+    installedConfig() = std::move(config);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "appointment.h"
+#include "calendar.h"
+
+constexpr int minutesPerDay = 24 * 60;
+
+// The services the shop offers, compiled into a perfect hash: every name (and alias) lands in its own table
+// cell, so a lookup is one hash, one cell and one string compare, however many services there are
+class ServiceCatalog {
+public:
+    struct Service {
+        std::string name;
+        int duration;
+        ServiceType kind;
+        bool alias; // another name for the service before it
+        int price = 0; // in cents, 0 if none is set
+    };
+
+    // register a service under name (and its aliases); call compile() once they are all added
+    void add(const std::string& name, int duration, const std::vector<std::string>& aliases = {});
+
+    // charge cents for the service called name (or one of its aliases), under all of its names; false if there
+    // is no such service
+    bool setPrice(std::string_view name, int cents);
+
+    // build the hash table: find a seed under which no two names share a cell, growing the table if needed
+    void compile();
+
+    // the service called name (or one of its aliases), or nullptr
+    const Service* find(std::string_view name) const {
+        if (table.empty()) return nullptr;
+        std::int16_t entry = table[hash(name, seed) & mask];
+        return entry >= 0 && services[entry].name == name ? &services[entry] : nullptr;
+    }
+
+    // "'hair' (30 min), 'beard' (15 min), ..." for help and error messages (aliases left out)
+    std::string describe() const;
+
+    // every service name, aliases included, in the order they were added
+    const std::vector<Service>& list() const { return services; }
+    
+    // the shortest service, in minutes (gaps shorter than this can't be booked)
+    int shortest() const { return shortestDuration; }
+
+private:
+    static std::uint32_t hash(std::string_view name, std::uint32_t seed) {
+        std::uint32_t h = 2166136261u ^ seed; // FNV-1a, seeded
+        for (char c : name) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+
+    std::vector<Service> services; // one entry per name, aliases included
+    std::vector<std::int16_t> table; // cell -> index into services, -1 if empty
+    std::uint32_t seed = 0;
+    std::uint32_t mask = 0;
+    int shortestDuration = 15;
+};
+
+// One weekday's hours, compiled: which minutes are bookable as a bitmap, and the same as the list of open
+// stretches [start, end) between breaks, which is what the slot searches walk. Admin override adds the
+// stretch from closing time to the override end
+struct DayHours {
+    std::bitset<minutesPerDay> open;
+    std::vector<std::pair<int, int>> runs;
+    std::vector<std::pair<int, int>> overrideRuns;
+    int opens = 0;  // first open minute, 0 if closed all day
+    int closes = 0; // end of the last open stretch, 0 if closed all day
+
+    bool isOpen(int minute) const { return minute >= 0 && minute < minutesPerDay && open[minute]; }
+    const std::vector<std::pair<int, int>>& bookable(bool adminOverride) const { return adminOverride ? overrideRuns : runs; }
+};
+
+// How the shop works: hours per weekday, breaks, the slot grid and the service catalog. Read from a config
+// file at startup (mirrorbooking.conf), otherwise the built-in defaults: open 10am-6pm every day, 10pm with
+// admin override, 15-minute slots, hair/haircut 30, beard 15, full/both 45
+//
+//   # <days> is a weekday (mon), a range (mon-fri), a list (mon,wed,fri) or 'daily'
+//   hours <days> <open>-<close> | closed
+//   break <days> <from>-<to>
+//   override <close>         # latest end of an after-hours booking
+//   interval <minutes>       # slot grid
+//   service <name> <minutes> [alias...]
+//   price <service> <amount> # what it costs, e.g. 25 or 37.50, for revenue in reports
+struct ShopConfig {
+    std::array<DayHours, 7> week; // by weekday, 0 = Sunday
+    int interval = 15;
+    int overrideEnd = 22 * 60;
+    ServiceCatalog services;
+
+    const DayHours& hoursOn(int day) const { return week[weekdayFromDays(day)]; }
+
+    // the defaults, compiled
+    static ShopConfig defaults();
+
+    // read a config file on top of the defaults; false (after reporting the line) if it has a mistake.
+    // A missing file is fine when optional is set
+    static bool load(const std::string& path, ShopConfig& config, bool optional);
+
+private:
+    void compileHours(const std::array<std::vector<std::pair<int, int>>, 7>& hours,
+                      const std::array<std::vector<std::pair<int, int>>, 7>& breaks);
+};
+
+// The configuration everything runs with. Install it with setShopConfig() at startup, before any thread starts;
+// until then it is ShopConfig::defaults()
+const ShopConfig& shopConfig();
+void setShopConfig(ShopConfig config);
@@ -0,0 +1,318 @@
+#include "daemon.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#ifndef _WIN32
+// Write all of text to a socket; false if the peer went away
+static bool sendAll(int fd, std::string_view text) {
+    while (!text.empty()) {
+        ssize_t n = ::send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        text.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+// Reads '\n'-terminated lines from a socket
+class SocketLineReader {
+public:
+    explicit SocketLineReader(int socketFd) : fd(socketFd) {}
+    
+    // next line without its newline; false at end of stream
+    bool next(std::string& line) {
+        while (true) {
+            size_t nl = buffer.find('\n', scanned);
+            if (nl != std::string::npos) {
+                line.assign(buffer, 0, nl);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                buffer.erase(0, nl + 1);
+                scanned = 0;
+                return true;
+            }
+            scanned = buffer.size();
+            if (!fill()) return false;
+        }
+    }
+    
+    // exactly bytes bytes, newlines and all (a reply body); false at end of stream
+    bool read(size_t bytes, std::string& text) {
+        while (buffer.size() < bytes) {
+            if (!fill()) return false;
+        }
+        text.assign(buffer, 0, bytes);
+        buffer.erase(0, bytes);
+        scanned = 0;
+        return true;
+    }
+    
+private:
+    bool fill() {
+        char chunk[4096];
+        ssize_t n;
+        do {
+            n = ::recv(fd, chunk, sizeof(chunk), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+    
+    int fd;
+    std::string buffer;
+    size_t scanned = 0;
+};
+
+// Connect to a daemon's socket; -1 (errno set) on failure
+static int connectSocket(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+// SIGINT/SIGTERM wake the daemon's accept loop through this pipe
+static int daemonWakePipe[2] = {-1, -1};
+extern "C" void wakeDaemon(int) {
+    char byte = 1;
+    ssize_t ignored = ::write(daemonWakePipe[1], &byte, 1);
+    (void)ignored;
+}
+
+int runDaemon(Session& session, const std::string& socketPath) {
+    int probe = connectSocket(socketPath);
+    if (probe >= 0) {
+        ::close(probe);
+        std::cerr << "Error: A daemon is already serving " << socketPath << std::endl;
+        return 1;
+    }
+    ::unlink(socketPath.c_str()); // left over from a daemon that didn't shut down cleanly
+    
+    sockaddr_un addr{};
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: Socket path is too long: " << socketPath << std::endl;
+        return 1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listenFd, 512) != 0) {
+        std::cerr << "Error: Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (listenFd >= 0) ::close(listenFd);
+        return 1;
+    }
+    if (::pipe(daemonWakePipe) != 0) {
+        std::cerr << "Error: " << std::strerror(errno) << std::endl;
+        ::close(listenFd);
+        return 1;
+    }
+    std::signal(SIGINT, wakeDaemon);
+    std::signal(SIGTERM, wakeDaemon);
+    
+    session.loadAll();
+    std::shared_mutex scheduleLock; // readers share it, writers take it alone
+    std::mutex clientsLock;
+    std::condition_variable clientsDone;
+    std::vector<int> clients; // open connections, so shutdown can wake them
+    
+    auto serve = [&](int fd) {
+        SocketLineReader reader(fd);
+        ViewState view;
+        std::ostringstream out, err;
+        CommandIO io{out, err, nullptr, view, true}; // shared: other connections run in between
+        std::string line, reply;
+        while (reader.next(line)) {
+            out.str("");
+            err.str("");
+            CommandResult result;
+            if (Session::readsOnly(line)) {
+                std::shared_lock<std::shared_mutex> guard(scheduleLock);
+                result = session.execute(line, io);
+            } else {
+                std::unique_lock<std::shared_mutex> guard(scheduleLock);
+                result = session.execute(line, io);
+                session.commit(); // durable before the client hears about it
+            }
+            if (result == CommandResult::exit) break;
+            
+            std::string body = out.str() + err.str();
+            reply = (result == CommandResult::ok ? "OK " : "ERR ") + std::to_string(body.size()) + "\n";
+            reply += body;
+            if (!sendAll(fd, reply)) break;
+        }
+        std::lock_guard<std::mutex> guard(clientsLock);
+        clients.erase(std::find(clients.begin(), clients.end(), fd));
+        ::close(fd);
+        clientsDone.notify_all();
+    };
+    
+    std::cout << "Serving " << session.storeName() << " on " << socketPath << " (Ctrl-C to stop)" << std::endl;
+    // other processes sharing the store: caught up with when the watcher says so, or every second without one
+    pollfd waits[3] = {{listenFd, POLLIN, 0}, {daemonWakePipe[0], POLLIN, 0}, {session.watchFd(), POLLIN, 0}};
+    nfds_t waitCount = session.watchFd() >= 0 ? 3 : 2;
+    while (true) {
+        int ready = ::poll(waits, waitCount, waitCount == 3 ? -1 : 1000);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (waits[1].revents) break; // asked to stop
+        if (ready == 0 || (waitCount == 3 && waits[2].revents)) { // mostly woken by this daemon's own writes
+            bool stale;
+            {
+                std::shared_lock<std::shared_mutex> guard(scheduleLock);
+                stale = session.stale();
+            }
+            if (stale) {
+                std::unique_lock<std::shared_mutex> guard(scheduleLock);
+                session.catchUp();
+            }
+        }
+        if (waits[0].revents & POLLIN) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) continue;
+            std::lock_guard<std::mutex> guard(clientsLock);
+            clients.push_back(fd);
+            std::thread(serve, fd).detach();
+        }
+    }
+    
+    // stop: wake every connection, wait for them to finish, then fold the journal like the prompt's exit
+    ::close(listenFd);
+    ::unlink(socketPath.c_str());
+    {
+        std::unique_lock<std::mutex> guard(clientsLock);
+        for (int fd : clients) ::shutdown(fd, SHUT_RDWR);
+        clientsDone.wait(guard, [&] { return clients.empty(); });
+    }
+    session.close();
+    std::cout << "Daemon stopped." << std::endl;
+    return 0;
+}
+
+int runDaemonBenchmark(const std::string& socketPath, int clientCount, int requestsPerClient) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<double>> readTimes(clientCount), writeTimes(clientCount); // microseconds
+    std::atomic<int> failures{0};
+    std::atomic<int> errors{0};
+    int firstDay = daysFromCivil(2090, 1, 1);
+    
+    auto client = [&](int c) {
+        int fd = connectSocket(socketPath);
+        if (fd < 0) {
+            ++failures;
+            return;
+        }
+        SocketLineReader reader(fd);
+        std::string header, body;
+        auto request = [&](const std::string& command) {
+            if (!sendAll(fd, command + "\n") || !reader.next(header)) return false;
+            if (!reader.read(std::stoul(header.substr(header.find(' ') + 1)), body)) return false;
+            if (header.compare(0, 3, "ERR") == 0) ++errors;
+            return true;
+        };
+        std::string name = "lg" + std::to_string(c); // this client's own bookings never collide with anyone's
+        bool booked = false;
+        for (int i = 0; i < requestsPerClient; ++i) {
+            std::string date = daysToDate(firstDay + c * requestsPerClient + i);
+            std::string command;
+            bool write = true;
+            if (i % 10 == 0) {
+                command = "add " + name + " 10am hair " + date;
+                booked = true;
+            } else if (i % 10 == 5 && booked) {
+                command = "del " + name + " 10am";
+                booked = false;
+            } else if (i % 2 == 0 || !booked) {
+                command = "display " + date;
+                write = false;
+            } else {
+                command = "client " + name;
+                write = false;
+            }
+            auto start = Clock::now();
+            if (!request(command)) {
+                ++failures;
+                break;
+            }
+            double micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            (write ? writeTimes : readTimes)[c].push_back(micros);
+        }
+        if (booked) request("del " + name + " 10am");
+        sendAll(fd, "exit\n");
+        ::close(fd);
+    };
+    
+    auto started = Clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clientCount; ++c) threads.emplace_back(client, c);
+    for (auto& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    
+    auto report = [](const char* label, std::vector<std::vector<double>>& perClient) {
+        std::vector<double> all;
+        for (auto& times : perClient) all.insert(all.end(), times.begin(), times.end());
+        if (all.empty()) return;
+        std::sort(all.begin(), all.end());
+        auto at = [&all](double p) { return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+        std::cout << "  " << std::left << std::setw(7) << label << std::right << std::setw(8) << all.size()
+                  << " requests   p50 " << std::setw(8) << at(0.50) << " us   p99 " << std::setw(8) << at(0.99)
+                  << " us   max " << std::setw(8) << all.back() << " us" << std::endl;
+    };
+    size_t total = 0;
+    for (int c = 0; c < clientCount; ++c) total += readTimes[c].size() + writeTimes[c].size();
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "Daemon benchmark: " << clientCount << " concurrent clients x " << requestsPerClient << " requests" << std::endl;
+    report("reads", readTimes);
+    report("writes", writeTimes);
+    std::cout << "  " << total << " requests in " << std::setprecision(2) << seconds << " s ("
+              << std::setprecision(0) << total / seconds << " requests/s), " << errors << " ERR replies, "
+              << failures << " connection failures" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+#else
+int runDaemon(Session&, const std::string&) {
+    std::cerr << "Error: Daemon mode needs Unix domain sockets and is not supported on Windows" << std::endl;
+    return 1;
+}
+
+int runDaemonBenchmark(const std::string&, int, int) {
+    std::cerr << "Error: Daemon mode needs Unix domain sockets and is not supported on Windows" << std::endl;
+    return 1;
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+#include "session.h"
+
+// Daemon mode (MirrorBooking --serve <socket>): keep the schedule in memory and serve the prompt's commands to
+// any number of local clients over a Unix domain socket.
+// Protocol: the client sends one command per line; every reply is a header line "OK <bytes>" or "ERR <bytes>"
+// followed by exactly that many bytes of output (what the prompt would have printed). "exit" closes the
+// connection. display/client/help run concurrently under a shared lock; everything else takes it
+// exclusively, one at a time, and each is synced to the journal before its reply goes out.
+// Ctrl-C (SIGINT) or SIGTERM stops the daemon and folds the journal into the store
+int runDaemon(Session& session, const std::string& socketPath);
+
+// Daemon load generator (MirrorBooking --bench-serve <socket> [clients] [requests per client]): many concurrent
+// connections against a running daemon, 80% reads (display a date, client lookup) and 20% writes (add then
+// del of the client's own booking, far in the future so real data is untouched). Reports latency percentiles
+int runDaemonBenchmark(const std::string& socketPath, int clientCount, int requestsPerClient);
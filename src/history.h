@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded undo/redo history: a ring of the last capacity entries, the oldest dropped first once it is full.
+// Recording a new entry throws away whatever had been undone, since there is nothing left to redo after it
+template <typename Entry>
+class UndoHistory {
+public:
+    explicit UndoHistory(size_t capacity) : ring(capacity) {}
+
+    void record(Entry entry) {
+        if (ring.empty()) return;
+        if (done == ring.size()) { // full: forget the oldest
+            oldest = (oldest + 1) % ring.size();
+            --done;
+        }
+        ring[(oldest + done) % ring.size()] = std::move(entry);
+        kept = ++done;
+    }
+
+    // the entry to undo (it stays in the ring for redo), or nullptr if there is none
+    Entry* undo() {
+        if (done == 0) return nullptr;
+        --done;
+        return &ring[(oldest + done) % ring.size()];
+    }
+
+    // the entry undone last, to apply again, or nullptr if there is none
+    Entry* redo() {
+        if (done == kept) return nullptr;
+        return &ring[(oldest + done++) % ring.size()];
+    }
+
+    // forget every entry (the schedule changed under them, so replaying them could undo someone else's change)
+    void clear() { oldest = done = kept = 0; }
+
+    size_t undoable() const { return done; }
+    size_t redoable() const { return kept - done; }
+
+private:
+    std::vector<Entry> ring;
+    size_t oldest = 0; // ring index of the oldest entry
+    size_t done = 0;   // entries that can be undone, counted from the oldest
+    size_t kept = 0;   // entries in the ring; done..kept can be redone
+};
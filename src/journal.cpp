@@ -0,0 +1,255 @@
+#include "journal.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+// parse the records in text into records; returns how many bytes of it are complete lines
+static size_t parseJournal(std::string_view text, std::vector<JournalRecord>& records) {
+    return forEachLine(text, [&](std::string_view line) {
+        JournalRecord record;
+        if (line.size() < 2 || (line[0] != '+' && line[0] != '-') || line[1] != '|' ||
+            !parseAppointmentRecord(line.substr(2), record.apt)) {
+            std::cerr << "Warning: skipping malformed journal record: " << line << std::endl;
+            return;
+        }
+        record.op = line[0];
+        records.push_back(record);
+    });
+}
+
+std::vector<JournalRecord> readJournal(const std::string& path, TextArena& arena, bool truncateTorn) {
+    std::vector<JournalRecord> records;
+    std::string_view text;
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return records;
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        text = arena.store(contents.str());
+    }
+    
+    size_t goodBytes = parseJournal(text, records); // anything after goodBytes has no newline: torn write, ignored
+    if (truncateTorn && goodBytes < text.size()) {
+        std::error_code ec;
+        std::filesystem::resize_file(path, goodBytes, ec);
+    }
+    return records;
+}
+
+size_t readJournalTail(const std::string& path, size_t offset, TextArena& arena, std::vector<JournalRecord>& records) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return offset;
+    file.seekg(static_cast<std::streamoff>(offset));
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string tail = contents.str();
+    size_t end = tail.rfind('\n');
+    if (end == std::string::npos) return offset; // nothing complete yet (or still being written)
+    size_t first = records.size();
+    size_t parsed = parseJournal(std::string_view(tail).substr(0, end + 1), records);
+    // read over and over by a process sharing the store: keep the records' fields, interned, rather than the tail
+    for (size_t i = first; i < records.size(); ++i) internAppointment(records[i].apt, arena);
+    return offset + parsed;
+}
+
+bool readJournalSince(const std::string& filename, StoreVersion& seen, TextArena& arena, std::vector<JournalRecord>& records) {
+    const std::string journalPath = filename + ".journal";
+    StoreVersion now = StoreVersion::of(filename);
+    if (now.journalInode != seen.journalInode || seen.journalInode == 0) {
+        if (seen.journalInode != 0 && StoreVersion::inodeOf(filename + ".journal.compacting") == seen.journalInode) {
+            readJournalTail(filename + ".journal.compacting", seen.journalBytes, arena, records); // rotated, not folded yet
+        } else if (now.snapshotInode != seen.snapshotInode) {
+            return false; // folded, with whatever was appended to it after seen
+        } // else it was removed empty by a process closing the store: nothing of it was missed
+        seen.journalBytes = 0;
+    } else if (now.journalBytes < seen.journalBytes) {
+        return false; // cut short: not the journal that was read
+    }
+    seen.journalInode = now.journalInode;
+    seen.journalBytes = now.journalInode ? readJournalTail(journalPath, seen.journalBytes, arena, records) : 0;
+    seen.snapshotInode = now.snapshotInode;
+    return true;
+}
+
+void Journal::reopenIfMoved() {
+    if (!file || StoreVersion::inodeOf(path) == openInode) return;
+    std::string journalPath = path;
+    close();
+    open(journalPath);
+}
+
+void applyJournal(const std::vector<JournalRecord>& records, std::vector<Appointment>& appointments, ScheduleIndex& index,
+                  size_t from) {
+    // find a live appointment identical to apt among appointments[from..], using the day bucket instead of a full scan
+    std::vector<bool> removed(appointments.size() - from, false);
+    auto findSame = [&](const Appointment& apt) -> size_t {
+        int resource = index.findResource(apt.resource);
+        if (const auto* day = resource < 0 ? nullptr : index.bookingsOn(resource, apt.day)) {
+            for (const auto& b : *day) {
+                if (b.slot >= from && !removed[b.slot - from] && sameBooking(appointments[b.slot], apt)) return b.slot;
+            }
+        }
+        return ScheduleIndex::noSlot;
+    };
+    
+    for (const auto& record : records) {
+        size_t existing = findSame(record.apt);
+        if (record.op == '+' && existing == ScheduleIndex::noSlot) {
+            appointments.push_back(record.apt);
+            removed.push_back(false);
+            index.insert(record.apt, appointments.size() - 1);
+        } else if (record.op == '-' && existing != ScheduleIndex::noSlot) {
+            removed[existing - from] = true;
+            index.unlink(appointments[existing], existing);
+        }
+    }
+    
+    // drop removed appointments in one pass and renumber the index once, instead of per delete
+    if (std::find(removed.begin(), removed.end(), true) == removed.end()) return;
+    if (from > 0) { // only the ones after from move: unlink them here and index them again below
+        for (size_t i = from; i < appointments.size(); ++i) {
+            if (!removed[i - from]) index.unlink(appointments[i], i);
+        }
+    }
+    size_t kept = from;
+    for (size_t i = from; i < appointments.size(); ++i) {
+        if (!removed[i - from]) appointments[kept++] = appointments[i];
+    }
+    appointments.resize(kept);
+    if (from > 0) {
+        index.insertFrom(appointments, from);
+    } else {
+        index.build(appointments);
+    }
+}
+
+void applyJournal(const std::vector<JournalRecord>& records, std::vector<Appointment>& appointments, ScheduleIndex& index,
+                  std::vector<size_t>& freeSlots) {
+    for (const auto& record : records) {
+        size_t existing = ScheduleIndex::noSlot;
+        int resource = index.findResource(record.apt.resource);
+        if (const auto* day = resource < 0 ? nullptr : index.bookingsOn(resource, record.apt.day)) {
+            for (const auto& b : *day) {
+                if (sameBooking(appointments[b.slot], record.apt)) {
+                    existing = b.slot;
+                    break;
+                }
+            }
+        }
+        if (record.op == '+' && existing == ScheduleIndex::noSlot) {
+            addAppointment(appointments, index, record.apt, freeSlots);
+        } else if (record.op == '-' && existing != ScheduleIndex::noSlot) {
+            removeAppointment(appointments, index, existing, freeSlots);
+        }
+    }
+}
+
+bool foldJournal(const std::string& filename, const std::string& journalPath) {
+    // one fold at a time across processes: a second one could remove a journal rotated after the first finished
+    StoreLock folding(filename + ".fold");
+    std::error_code ec;
+    if (!std::filesystem::exists(journalPath, ec)) return true; // folded by another process meanwhile
+    TextArena snapshotText;
+    std::vector<Appointment> snapshot;
+    ScheduleIndex snapshotIndex;
+    try {
+        loadSnapshot(snapshot, filename, snapshotText);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+    snapshotIndex.build(snapshot);
+    applyJournal(readJournal(journalPath, snapshotText), snapshot, snapshotIndex);
+    
+    // written next to the store (same extension, so the same format) without holding the store up, then swapped in
+    // together with dropping the journal, so readers see either the old snapshot and the journal or neither
+    std::filesystem::path folded(filename);
+    folded.replace_filename(folded.stem().string() + ".folded" + folded.extension().string());
+    if (!saveSnapshot(snapshot, folded.string())) return false;
+    StoreLock lock(filename);
+    std::filesystem::rename(folded, filename, ec);
+    if (ec) {
+        std::cerr << "Error: Could not replace " << filename << ": " << ec.message() << std::endl;
+        std::filesystem::remove(folded, ec);
+        return false;
+    }
+    syncDirectory(folded.parent_path().string());
+    std::filesystem::remove(journalPath, ec);
+    return true;
+}
+
+size_t recoverAppointments(std::vector<Appointment>& appointments, ScheduleIndex& index, DayPager& pager,
+                           const std::string& filename, TextArena& arena, const LoadWindow& window, bool readOnly,
+                           StoreVersion* version) {
+    const std::string compactingPath = filename + ".journal.compacting";
+    const std::string journalPath = filename + ".journal";
+    std::vector<JournalRecord> journal;
+    std::error_code ec;
+    if (!readOnly && std::filesystem::exists(compactingPath, ec)) foldJournal(filename, compactingPath);
+    
+    // the snapshot and the journals are read as one version of the store: a fold swaps in its snapshot and drops
+    // the journal it folded under the lock, and a torn tail is only cut while nobody can be appending
+    StoreLock lock(filename, readOnly ? StoreLock::Mode::shared : StoreLock::Mode::exclusive);
+    if (std::filesystem::exists(compactingPath, ec)) {
+        journal = readJournal(compactingPath, arena); // rotated (or left unfolded): older than the live journal, so replayed first
+    }
+    size_t folded = journal.size();
+    std::vector<JournalRecord> live = readJournal(journalPath, arena, !readOnly);
+    journal.insert(journal.end(), live.begin(), live.end());
+    size_t journalRecords = journal.size() - folded;
+    if (!readOnly && !std::filesystem::exists(journalPath, ec)) {
+        std::ofstream(journalPath, std::ios::binary | std::ios::app); // the journal this process will append to is in the version
+    }
+    if (version) *version = StoreVersion::of(filename);
+    
+    if (isBinaryStore(filename)) {
+        BinarySnapshot snapshot;
+        snapshot.open(filename, arena);
+        pager.open(std::move(snapshot), std::move(journal));
+    } else if (window.enabled) {
+        TextSnapshot snapshot;
+        snapshot.open(filename, arena);
+        pager.open(std::move(snapshot), std::move(journal));
+    } else {
+        loadAppointments(appointments, filename, arena);
+        index.build(appointments);
+        applyJournal(journal, appointments, index);
+        return journalRecords;
+    }
+    
+    if (window.enabled) {
+        int today = getCurrentDay();
+        pager.ensureLoaded(today - window.pastDays, today + window.futureDays, appointments, index, arena);
+    } else {
+        pager.loadAll(appointments, index, arena);
+    }
+    return journalRecords;
+}
+
+int convertStore(const std::string& from, const std::string& to) {
+    TextArena arena;
+    std::vector<Appointment> appointments;
+    ScheduleIndex index;
+    try {
+        loadSnapshot(appointments, from, arena);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    index.build(appointments);
+    applyJournal(readJournal(from + ".journal.compacting", arena), appointments, index);
+    applyJournal(readJournal(from + ".journal", arena), appointments, index);
+    if (!saveSnapshot(appointments, to)) return 1;
+    std::vector<RecurrenceRule> rules = loadRules(from + ".rules", arena);
+    if (!rules.empty() && !saveRules(rules, to + ".rules")) return 1;
+    std::vector<WaitlistRecord> records;
+    readWaitlist(from + ".waitlist", 0, arena, records);
+    Waitlist waiting;
+    for (const auto& record : records) waiting.apply(record);
+    if (!waiting.empty() && !saveWaitlist(waiting.entries(), to + ".waitlist")) return 1;
+    std::cout << "Converted " << appointments.size() << " appointment(s) from " << from << " to " << to << std::endl;
+    return 0;
+}
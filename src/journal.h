@@ -0,0 +1,313 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "schedule.h"
+#include "stats.h"
+#include "storage.h"
+#include "storewatch.h"
+
+// One '+' (added) or '-' (removed) record from a journal
+struct JournalRecord {
+    char op;
+    Appointment apt;
+};
+
+// Read the records of a journal file; their text is copied into the arena so the file itself can go away.
+// A torn last line (no trailing newline) is ignored and, if truncateTorn is set, cut off so later appends
+// start on a clean line
+std::vector<JournalRecord> readJournal(const std::string& path, TextArena& arena, bool truncateTorn = false);
+
+// Read the complete records of a journal file from byte offset on (what another process appended since it was
+// last read) into records, their fields interned in the arena. Returns the offset just past the last complete
+// record, where the next read starts
+size_t readJournalTail(const std::string& path, size_t offset, TextArena& arena, std::vector<JournalRecord>& records);
+
+// Read what other processes journaled since a store was loaded at version seen into records (the rotated journal's
+// rest first if it was rotated meanwhile), and move seen's journal part up to where that left off; the rules are
+// the caller's. Call with the store locked (shared will do). false if the journal was folded or removed since, so
+// its records can't be told apart any more and the store has to be loaded again
+bool readJournalSince(const std::string& filename, StoreVersion& seen, TextArena& arena, std::vector<JournalRecord>& records);
+
+// whether a and b are the same booking, as a '-' record names the one it removes
+inline bool sameBooking(const Appointment& a, const Appointment& b) {
+    return a.start == b.start && a.duration == b.duration && a.name == b.name && a.time == b.time &&
+           a.service == b.service && a.resource == b.resource;
+}
+
+// Apply journal records on top of the loaded appointments.
+// Replay is idempotent: '+' skips an appointment that is already present and '-' only removes an exact match,
+// so replaying a journal that was already folded into the snapshot (crash mid-compaction) changes nothing.
+// Removed appointments are dropped and the ones after them renumbered, so this is for appointments nobody holds
+// slots of yet: a whole load, or appointments[from..] just paged in (only those are matched, or move)
+void applyJournal(const std::vector<JournalRecord>& records, std::vector<Appointment>& appointments, ScheduleIndex& index,
+                  size_t from = 0);
+
+// The same for appointments already in use: every slot keeps its number, a removed one is only unlinked and left
+// in freeSlots (as removeAppointment does) and an added one may take a free slot
+void applyJournal(const std::vector<JournalRecord>& records, std::vector<Appointment>& appointments, ScheduleIndex& index,
+                  std::vector<size_t>& freeSlots);
+
+// Which days to materialize at startup; anything outside is paged in when a command asks for it
+struct LoadWindow {
+    bool enabled = false; // text stores load everything unless a window is asked for; binary stores always page
+    int pastDays = 7;
+    int futureDays = 90;
+};
+
+// Keeps track of which days are in memory when a snapshot is paged in on demand.
+// Journal records for days that aren't loaded yet wait in pending until their day is paged in
+class DayPager {
+public:
+    // start paging from a snapshot; nothing is in memory yet
+    void open(BinarySnapshot&& source, std::vector<JournalRecord>&& journal) {
+        binary = std::move(source);
+        fromBinary = true;
+        start(std::move(journal));
+    }
+    void open(TextSnapshot&& source, std::vector<JournalRecord>&& journal) {
+        text = std::move(source);
+        fromBinary = false;
+        start(std::move(journal));
+    }
+    
+    // everything is in memory (always true when the store was loaded in full)
+    bool complete() const { return !paging; }
+    
+    // whether day is in memory
+    bool hasDay(int day) const {
+        if (!paging) return true;
+        return std::any_of(loaded.begin(), loaded.end(), [day](const std::pair<int, int>& range) {
+            return range.first <= day && day <= range.second;
+        });
+    }
+    
+    // hold a record for a day that isn't in memory (another process changed it) until the day is paged in
+    void defer(const JournalRecord& record) { pending.push_back(record); }
+    
+    // make sure days first..last are in memory, reading only the ones that aren't yet
+    void ensureLoaded(int first, int last, std::vector<Appointment>& appointments, ScheduleIndex& index, TextArena& arena) {
+        if (!paging) return;
+        // walk the sorted, disjoint loaded ranges and read the gaps between them
+        int cursor = first;
+        std::vector<std::pair<int, int>> missing;
+        for (const auto& range : loaded) {
+            if (range.second < cursor) continue;
+            if (range.first > last) break;
+            if (range.first > cursor) missing.push_back({cursor, range.first - 1});
+            cursor = range.second + 1;
+            if (cursor > last) break;
+        }
+        if (cursor <= last) missing.push_back({cursor, last});
+        
+        for (const auto& gap : missing) {
+            size_t before = appointments.size();
+            if (fromBinary) {
+                binary.readRange(gap.first, gap.second, appointments, arena);
+            } else {
+                text.readRange(gap.first, gap.second, appointments, arena);
+            }
+            index.insertFrom(appointments, before);
+            
+            // journal records for these days apply now, in their original order
+            std::vector<JournalRecord> due;
+            auto stillPending = std::stable_partition(pending.begin(), pending.end(), [&gap](const JournalRecord& r) {
+                return r.apt.day < gap.first || r.apt.day > gap.second;
+            });
+            due.assign(stillPending, pending.end());
+            pending.erase(stillPending, pending.end());
+            if (!due.empty()) applyJournal(due, appointments, index, before); // only the days just read move
+            markLoaded(gap.first, gap.second);
+        }
+    }
+    
+    // page in everything that's left (for lookups by name, which can hit any date)
+    void loadAll(std::vector<Appointment>& appointments, ScheduleIndex& index, TextArena& arena) {
+        if (!paging) return;
+        // sized once for the whole snapshot (and what the journal may add), rather than doubling as it is read
+        appointments.reserve(std::max(appointments.size(), fromBinary ? binary.size() : text.size()) + pending.size());
+        ensureLoaded(std::numeric_limits<int>::min() / 2, std::numeric_limits<int>::max() / 2, appointments, index, arena);
+        paging = false;
+    }
+    
+private:
+    void start(std::vector<JournalRecord>&& journal) {
+        pending = std::move(journal);
+        paging = true;
+        loaded.clear();
+    }
+    
+    void markLoaded(int first, int last) {
+        loaded.push_back({first, last});
+        std::sort(loaded.begin(), loaded.end());
+        std::vector<std::pair<int, int>> merged;
+        for (const auto& range : loaded) {
+            if (!merged.empty() && range.first <= merged.back().second + 1) {
+                merged.back().second = std::max(merged.back().second, range.second);
+            } else {
+                merged.push_back(range);
+            }
+        }
+        loaded.swap(merged);
+    }
+    
+    BinarySnapshot binary;
+    TextSnapshot text;
+    bool fromBinary = false;
+    std::vector<JournalRecord> pending;
+    std::vector<std::pair<int, int>> loaded; // sorted, disjoint day ranges already in memory
+    bool paging = false;
+};
+
+// Append-only log of changes since the last snapshot. Each add/del/reschedule appends one
+// '+' or '-' record instead of rewriting the whole file; commit() makes them durable with a single fsync
+class Journal {
+public:
+    static constexpr size_t maxPending = 64; // force a commit if this many records are waiting
+    
+    ~Journal() { close(); }
+    
+    bool open(const std::string& journalPath, size_t existingRecords = 0) {
+        close();
+        path = journalPath;
+        file = std::fopen(path.c_str(), "ab");
+        openInode = StoreVersion::inodeOf(path);
+        records = existingRecords;
+        pending = 0;
+        return file != nullptr;
+    }
+    
+    void close() {
+        if (file) {
+            commit();
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+    
+    // queue one record; written through to the OS right away, synced to disk on commit()
+    void append(char op, const Appointment& apt) {
+        if (!file) return;
+        std::string record(1, op);
+        record += '|';
+        record += formatAppointmentRecord(apt);
+        record += '\n';
+        std::fwrite(record.data(), 1, record.size(), file);
+        stats().journalBytes.fetch_add(record.size(), std::memory_order_relaxed);
+        ++records;
+        if (++pending >= maxPending && !holding) commit();
+    }
+    
+    // hand what was appended to the OS now, so other processes reading the journal see it (commit() still syncs)
+    void flush() {
+        if (file) std::fflush(file);
+    }
+    
+    // another process rotated the journal aside for compaction (or folded and removed it): append to the file
+    // that is at the journal's path now instead. Call with the store locked
+    void reopenIfMoved();
+    
+    // keep every record pending until the next commit(), instead of syncing each maxPending (one fsync per batch)
+    void hold() { holding = true; }
+    
+    // fsync everything appended since the last commit (one fsync per command/batch, not per record)
+    void commit() {
+        holding = false;
+        if (!file || pending == 0) return;
+        ScopedTimer timer(stats().journalSync);
+        if (!syncFile(file)) {
+            std::cerr << "Error: Could not sync journal " << path << std::endl;
+        }
+        pending = 0;
+    }
+    
+    size_t size() const { return records; } // records since the last compaction
+    const std::string& filePath() const { return path; }
+    
+private:
+    std::string path;
+    std::FILE* file = nullptr;
+    std::uint64_t openInode = 0; // the file it appends to, to notice it was moved
+    size_t records = 0;
+    size_t pending = 0;
+    bool holding = false;
+};
+
+// Fold a journal into the snapshot file: load snapshot, replay journal, write a new snapshot atomically, drop the journal.
+// Works purely from disk, so it can run on a background thread while the main thread keeps appending to a fresh journal.
+// Takes "<store>.fold.lock" for the whole fold and the store's lock only to swap the new snapshot in; never call it
+// with the store locked
+bool foldJournal(const std::string& filename, const std::string& journalPath);
+
+// Runs journal compaction in the background. The live journal is renamed aside (".compacting") and
+// replaced by an empty one, then a worker thread folds the renamed journal into a new snapshot. Call maybeStart
+// with the store locked (the rotation is a write), and don't wait() for the fold while holding it
+class Compactor {
+public:
+    static constexpr size_t threshold = 512; // journal records before a background compaction kicks in
+    
+    ~Compactor() { wait(); }
+    
+    // start a background compaction if the journal is big enough (or force it) and none is running
+    void maybeStart(const std::string& filename, Journal& journal, bool force = false) {
+        if (running.load()) return;
+        wait();
+        if (!force && journal.size() < threshold) return;
+        
+        const std::string compactingPath = filename + ".journal.compacting";
+        std::error_code ec;
+        if (!std::filesystem::exists(compactingPath, ec)) { // otherwise an earlier fold failed; retry it before rotating again
+            if (journal.size() == 0) return;
+            const std::string journalPath = journal.filePath();
+            journal.close(); // commits pending records
+            std::filesystem::rename(journalPath, compactingPath, ec);
+            journal.open(journalPath);
+            if (ec) {
+                std::cerr << "Error: Could not rotate journal: " << ec.message() << std::endl;
+                return;
+            }
+        }
+        
+        running = true;
+        worker = std::thread([this, filename, compactingPath]() {
+            if (!foldJournal(filename, compactingPath)) {
+                std::cerr << "Warning: journal compaction failed, will retry later" << std::endl;
+            }
+            running = false;
+        });
+    }
+    
+    // block until the current compaction (if any) is done
+    void wait() {
+        if (worker.joinable()) worker.join();
+    }
+    
+private:
+    std::thread worker;
+    std::atomic<bool> running{false};
+};
+
+// Startup recovery: finish any interrupted compaction, then load the snapshot and replay the live journal.
+// With a load window (always, for binary stores) only the window around today is materialized here;
+// the pager reads other days as commands touch them.
+// A readOnly recovery (the mirror, watching a store another process owns) writes nothing: it replays a
+// journal that is still being compacted instead of folding it, and leaves a torn tail alone.
+// version, if given, gets the version of the store that was loaded, to catch up from later.
+// Returns the number of records in the live journal; throws std::runtime_error if the snapshot can't be read
+size_t recoverAppointments(std::vector<Appointment>& appointments, ScheduleIndex& index, DayPager& pager,
+                           const std::string& filename, TextArena& arena, const LoadWindow& window, bool readOnly = false,
+                           StoreVersion* version = nullptr);
+
+// Convert a store between the text and binary formats (MirrorBooking --convert <from> <to>).
+// The source's journal, if any, is folded in, so a live store can be migrated as-is; its recurring rules go along
+int convertStore(const std::string& from, const std::string& to);
@@ -0,0 +1,188 @@
+#include "lineeditor.h"
+
+#include "render.h"
+
+#include <cerrno>
+#include <iostream>
+
+#ifndef _WIN32
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+bool LineEditor::readLine(const std::string& prompt, std::string& line) {
+#ifndef _WIN32
+    if (::isatty(STDIN_FILENO) && ::isatty(STDOUT_FILENO)) return editLine(prompt, line);
+#endif
+    std::cout << prompt << std::flush;
+    return static_cast<bool>(std::getline(std::cin, line));
+}
+
+#ifndef _WIN32
+// Keys one at a time, unechoed, for as long as it lives; the terminal is put back as it was after
+namespace {
+class RawTerminal {
+public:
+    RawTerminal() {
+        active = ::tcgetattr(STDIN_FILENO, &original) == 0;
+        if (!active) return;
+        termios raw = original;
+        raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | IEXTEN | ISIG); // Ctrl-C reaches the editor
+        raw.c_iflag &= ~static_cast<tcflag_t>(IXON | ICRNL);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        active = ::tcsetattr(STDIN_FILENO, TCSADRAIN, &raw) == 0;
+    }
+    ~RawTerminal() {
+        if (active) ::tcsetattr(STDIN_FILENO, TCSADRAIN, &original);
+    }
+    bool ok() const { return active; }
+
+private:
+    termios original{};
+    bool active = false;
+};
+
+// one byte from the terminal; false at the end of input
+bool readKey(char& key) {
+    while (true) {
+        ssize_t n = ::read(STDIN_FILENO, &key, 1);
+        if (n == 1) return true;
+        if (n < 0 && errno == EINTR) continue;
+        return false;
+    }
+}
+} // namespace
+
+bool LineEditor::editLine(const std::string& prompt, std::string& line) {
+    RawTerminal terminal;
+    if (!terminal.ok()) {
+        std::cout << prompt << std::flush;
+        return static_cast<bool>(std::getline(std::cin, line));
+    }
+    std::cout.flush();
+    line.clear();
+    size_t cursor = 0;
+    size_t recalled = history.size(); // history[recalled] is on the line; history.size() is the line being typed
+    std::string typed;
+    auto redraw = [&]() {
+        std::string screen = "\r" + prompt + line + "\x1b[K";
+        if (cursor < line.size()) screen += "\x1b[" + std::to_string(line.size() - cursor) + "D";
+        writeStdout(screen);
+    };
+    auto recall = [&](size_t entry) {
+        if (recalled == history.size()) typed = line;
+        recalled = entry;
+        line = recalled == history.size() ? typed : history[recalled];
+        cursor = line.size();
+    };
+    redraw();
+
+    bool tabbed = false; // the key before was Tab too: list the choices
+    char key;
+    while (readKey(key)) {
+        bool tab = key == '\t';
+        switch (key) {
+            case '\r':
+            case '\n':
+                writeStdout("\n");
+                if (!line.empty() && (history.empty() || history.back() != line)) history.push_back(line);
+                return true;
+            case '\t':
+                complete(prompt, line, cursor, tabbed);
+                break;
+            case 127: // backspace
+            case 8:
+                if (cursor > 0) line.erase(--cursor, 1);
+                break;
+            case 1: // Ctrl-A
+                cursor = 0;
+                break;
+            case 5: // Ctrl-E
+                cursor = line.size();
+                break;
+            case 21: // Ctrl-U
+                line.erase(0, cursor);
+                cursor = 0;
+                break;
+            case 11: // Ctrl-K
+                line.erase(cursor);
+                break;
+            case 3: // Ctrl-C: drop the line, or leave like Ctrl-D when there is none
+            case 4: // Ctrl-D: end of input at an empty line, otherwise delete under the cursor
+                if (line.empty()) {
+                    writeStdout("\n");
+                    return false;
+                }
+                if (key == 3) {
+                    line.clear();
+                    cursor = 0;
+                    writeStdout("^C\n");
+                } else if (cursor < line.size()) {
+                    line.erase(cursor, 1);
+                }
+                break;
+            case 27: { // escape sequences: arrows, Home/End, Delete
+                char kind, code;
+                if (!readKey(kind) || !readKey(code)) break;
+                if (kind == '[' && code >= '0' && code <= '9') { // "ESC [ n ~"
+                    char tilde;
+                    if (!readKey(tilde) || tilde != '~') break;
+                    if (code == '3' && cursor < line.size()) line.erase(cursor, 1);
+                    if (code == '1' || code == '7') cursor = 0;
+                    if (code == '4' || code == '8') cursor = line.size();
+                    break;
+                }
+                if (kind != '[' && kind != 'O') break;
+                if (code == 'C' && cursor < line.size()) ++cursor;
+                if (code == 'D' && cursor > 0) --cursor;
+                if (code == 'H') cursor = 0;
+                if (code == 'F') cursor = line.size();
+                if (code == 'A' && recalled > 0) recall(recalled - 1);
+                if (code == 'B' && recalled < history.size()) recall(recalled + 1);
+                break;
+            }
+            default:
+                if (static_cast<unsigned char>(key) >= 32) line.insert(cursor++, 1, key);
+                break;
+        }
+        tabbed = tab;
+        redraw();
+    }
+    writeStdout("\n");
+    return !line.empty(); // input ended partway through a line: run what there is
+}
+
+void LineEditor::complete(const std::string& prompt, std::string& line, size_t& cursor, bool listing) {
+    Completion completion = completer(line, cursor);
+    if (completion.total == 0) {
+        writeStdout("\a");
+        return;
+    }
+    std::string text = completion.text;
+    if (completion.total == 1 && (cursor == line.size() || line[cursor] != ' ')) text += ' ';
+    if (text != line.substr(completion.start, cursor - completion.start)) {
+        line.replace(completion.start, cursor - completion.start, text);
+        cursor = completion.start + text.size();
+        return;
+    }
+    if (!listing) { // nothing more to fill in: the next Tab lists the choices
+        writeStdout("\a");
+        return;
+    }
+    std::string list = "\n";
+    for (const auto& option : completion.options) list += option + "  ";
+    if (completion.total > completion.options.size()) {
+        list += "... " + std::to_string(completion.total - completion.options.size()) + " more";
+    }
+    list += "\n" + prompt;
+    writeStdout(list);
+}
+#else
+bool LineEditor::editLine(const std::string& prompt, std::string& line) {
+    std::cout << prompt << std::flush;
+    return static_cast<bool>(std::getline(std::cin, line));
+}
+
+void LineEditor::complete(const std::string&, std::string&, size_t&, bool) {}
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// What Tab does at the cursor: line[start, cursor) becomes text, and when that doesn't settle it, options
+// are listed
+struct Completion {
+    size_t start = 0;
+    std::string text;
+    std::vector<std::string> options;
+    size_t total = 0; // every match; options may hold only the first of them
+};
+
+using Completer = std::function<Completion(const std::string& line, size_t cursor)>;
+
+// The prompt's line editor. On a terminal it reads keys in raw mode: Tab completes the word at the cursor
+// (twice lists the choices), arrows move and go through the lines entered before, Ctrl-A/E jump to the
+// start/end, Ctrl-U clears and Ctrl-D at an empty line ends input. Anywhere else (a pipe, Windows) it
+// reads plain lines
+class LineEditor {
+public:
+    explicit LineEditor(Completer completer) : completer(std::move(completer)) {}
+
+    // show prompt and read one line; false at the end of input
+    bool readLine(const std::string& prompt, std::string& line);
+
+private:
+    bool editLine(const std::string& prompt, std::string& line);
+    void complete(const std::string& prompt, std::string& line, size_t& cursor, bool listing);
+
+    Completer completer;
+    std::vector<std::string> history;
+};
@@ -0,0 +1,236 @@
+#include "locations.h"
+
+#include "render.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+bool Locations::parse(const std::string& list, std::vector<Store>& stores) {
+    std::istringstream entries(list);
+    for (std::string entry; std::getline(entries, entry, ',');) {
+        if (entry.empty()) continue;
+        size_t equals = entry.find('=');
+        Store store;
+        store.file = equals == std::string::npos ? entry : entry.substr(equals + 1);
+        store.name = equals == std::string::npos ? std::filesystem::path(entry).stem().string() : entry.substr(0, equals);
+        if (store.name.empty() || store.file.empty() || store.name.find(' ') != std::string::npos) {
+            std::cerr << "Error: --locations takes <name>=<store>,... (got '" << entry << "')" << std::endl;
+            return false;
+        }
+        for (const auto& other : stores) {
+            if (other.name == store.name) {
+                std::cerr << "Error: Location '" << store.name << "' is given twice" << std::endl;
+                return false;
+            }
+        }
+        stores.push_back(store);
+    }
+    if (stores.empty()) {
+        std::cerr << "Error: --locations needs at least one <name>=<store>" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Locations::open(const std::vector<Store>& stores, const LoadWindow& window, const std::vector<std::string>& chairs,
+                     const SlotRanking& ranking) {
+    for (const auto& store : stores) {
+        names.push_back(store.name);
+        shards.push_back(std::make_unique<Session>());
+        shards.back()->setSlotRanking(ranking);
+    }
+    std::vector<char> opened(stores.size(), 0);
+    pool.forEach(stores.size(), [&](size_t i) { // every store is read and replayed at the same time
+        opened[i] = shards[i]->open(stores[i].file, window, chairs);
+    });
+    for (size_t i = 0; i < stores.size(); ++i) {
+        if (!opened[i]) {
+            std::cerr << "Error: Could not open location '" << names[i] << "' (" << stores[i].file << ")" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+CommandResult Locations::execute(const std::string& input, CommandIO& io) {
+    std::istringstream iss(input);
+    std::string command, what;
+    iss >> command;
+    std::string args;
+    std::getline(iss >> std::ws, args);
+    if (command == "location") return locationCommand(args, io);
+    if (command == "all") {
+        std::istringstream rest(args);
+        rest >> what;
+        std::getline(rest >> std::ws, args);
+        if (what == "slots") return allSlots(args, io);
+        if (what == "display") return allWeekly(args, io);
+        io.err << "Error: Use 'all slots <service> [date] [ranking]' or 'all display weekly [next|prev]'" << std::endl;
+        return CommandResult::failed;
+    }
+    if (command == "exit") {
+        for (size_t i = 0; i < shards.size(); ++i) { // let every location roll back an open transaction
+            if (i != active) shards[i]->execute("exit", io);
+        }
+    }
+    return shards[active]->execute(input, io);
+}
+
+void Locations::close() {
+    pool.forEach(shards.size(), [&](size_t i) { shards[i]->close(); });
+}
+
+std::string Locations::label(size_t location, int resource) const {
+    if (shards[location]->chairCount() <= 1) return names[location];
+    std::string_view chair = shards[location]->chairName(resource);
+    return names[location] + "/" + std::string(chair.empty() ? "1" : chair);
+}
+
+CommandResult Locations::locationCommand(const std::string& args, CommandIO& io) {
+    if (args.empty()) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            io.out << (i == active ? "* " : "  ") << std::left << std::setw(16) << names[i] << shards[i]->storeName() << std::endl;
+        }
+        return CommandResult::ok;
+    }
+    auto found = std::find(names.begin(), names.end(), args);
+    if (found == names.end()) {
+        io.err << "Error: Unknown location '" << args << "'. Locations:";
+        for (const auto& name : names) io.err << " " << name;
+        io.err << std::endl;
+        return CommandResult::failed;
+    }
+    active = static_cast<size_t>(found - names.begin());
+    io.view.weekStart = getWeekStart(); // weekly/monthly navigation starts over at the new location
+    io.view.month = currentMonthNumber();
+    io.out << "Now at " << names[active] << " (" << shards[active]->storeName() << ")" << std::endl;
+    return CommandResult::ok;
+}
+
+CommandResult Locations::allSlots(const std::string& args, CommandIO& io) {
+    if (args.find('@') != std::string::npos) {
+        io.err << "Error: Chairs differ between locations; use 'location <name>' and 'slots ... @chair' instead" << std::endl;
+        return CommandResult::failed;
+    }
+    SlotSearch search;
+    if (!shards[active]->parseSlotSearch(args, search, io)) return CommandResult::failed;
+
+    // every location searches its own schedule at the same time; the best of all of them win
+    std::vector<std::vector<SlotCandidate>> found(shards.size());
+    pool.forEach(shards.size(), [&](size_t i) { found[i] = shards[i]->bestSlots(search); });
+    std::vector<std::pair<SlotCandidate, size_t>> merged;
+    for (size_t i = 0; i < found.size(); ++i) {
+        for (const auto& slot : found[i]) merged.push_back({slot, i});
+    }
+    size_t keep = std::min(merged.size(), search.count);
+    std::partial_sort(merged.begin(), merged.begin() + static_cast<std::ptrdiff_t>(keep), merged.end(), [](const auto& a, const auto& b) {
+        return a.first.before(b.first) || (!b.first.before(a.first) && a.second < b.second);
+    });
+    merged.resize(keep);
+
+    std::ostream& out = io.view.frame.stream();
+    out << "\n===== Free " << search.duration << "-minute slots from " << daysToDate(search.firstDay)
+        << " at any location (" << search.ranking.describe() << ") =====\n" << '\n';
+    if (merged.empty()) out << "[Nothing free in the next " << search.days << " days]" << '\n';
+    for (size_t i = 0; i < merged.size(); ++i) {
+        const SlotCandidate& slot = merged[i].first;
+        out << "  " << i + 1 << ". " << std::left << std::setw(10) << dayOfWeekName(slot.day) << daysToDate(slot.day)
+            << " at " << minutesToTime(slot.start) << " - " << label(merged[i].second, slot.resource) << '\n';
+    }
+    Session::showFrame(io);
+    return CommandResult::ok;
+}
+
+CommandResult Locations::allWeekly(const std::string& args, CommandIO& io) {
+    std::istringstream iss(args);
+    std::string view, navigation;
+    iss >> view >> navigation;
+    if (view != "weekly" && view != "week") {
+        io.err << "Error: Only the weekly view spans every location: all display weekly [next|prev]" << std::endl;
+        return CommandResult::failed;
+    }
+    if (navigation == "next") {
+        io.view.weekStart = addDaysToDate(io.view.weekStart, 7);
+    } else if (navigation == "prev" || navigation == "previous") {
+        io.view.weekStart = addDaysToDate(io.view.weekStart, -7);
+    } else {
+        io.view.weekStart = getWeekStart();
+    }
+    int first = dateToDays(io.view.weekStart);
+
+    // each location pages in and expands its own week at the same time
+    std::vector<std::vector<Appointment>> weeks(shards.size());
+    std::vector<TextArena> dates(shards.size());
+    pool.forEach(shards.size(), [&](size_t i) { weeks[i] = shards[i]->bookingsBetween(first, first + 6, dates[i]); });
+
+    // merged into one schedule whose chairs are the locations (and their chairs)
+    TextArena labels;
+    ScheduleIndex index;
+    std::vector<Appointment> merged;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        for (int r = 0; r < shards[i]->chairCount(); ++r) index.addResource(labels.store(label(i, r)));
+    }
+    for (size_t i = 0; i < shards.size(); ++i) {
+        for (Appointment apt : weeks[i]) {
+            apt.resource = index.resourceName(index.findResource(label(i, std::max(0, shards[i]->findChair(apt.resource)))));
+            index.insert(apt, merged.size());
+            merged.push_back(apt);
+        }
+    }
+    io.view.frame.stream() << "\nLocations: ";
+    for (size_t i = 0; i < names.size(); ++i) io.view.frame.stream() << (i ? ", " : "") << names[i];
+    io.view.frame.stream() << '\n';
+    displayWeeklySchedule(io.view.frame, merged, index, io.view.weekStart);
+    Session::showFrame(io);
+    return CommandResult::ok;
+}
+
+Completion Locations::complete(const std::string& line, size_t cursor) {
+    std::string_view before = std::string_view(line).substr(0, std::min(cursor, line.size()));
+    size_t space = before.find_last_of(' ');
+    size_t start = space == std::string_view::npos ? 0 : space + 1;
+    std::string_view word = before.substr(start);
+    std::istringstream iss{std::string(before.substr(0, start))};
+    std::vector<std::string> words;
+    for (std::string each; iss >> each;) words.push_back(each);
+
+    Completion completion;
+    completion.start = start;
+    std::vector<std::string> extra; // this layer's own words
+    if (words.empty()) {
+        completion = shards[active]->complete(line, cursor);
+        extra = {"all", "location"};
+    } else if (words[0] == "location" && words.size() == 1) {
+        extra = names;
+    } else if (words[0] == "all") {
+        if (words.size() == 1) extra = {"display", "slots"};
+        if (words.size() == 2 && words[1] == "display") extra = {"weekly"};
+        if (words.size() >= 2 && words[1] == "slots") { // complete it like 'slots ...' at the current location
+            size_t offset = line.find("slots");
+            completion = shards[active]->complete(line.substr(offset), cursor - offset);
+            completion.start += offset;
+        }
+    } else {
+        return shards[active]->complete(line, cursor);
+    }
+
+    if (extra.empty()) return completion;
+    for (const auto& each : extra) {
+        if (each.compare(0, word.size(), word) != 0) continue;
+        completion.options.push_back(each);
+        ++completion.total;
+    }
+    std::sort(completion.options.begin(), completion.options.end());
+    if (completion.options.empty()) return completion;
+    std::string common = completion.options.front();
+    for (const auto& option : completion.options) {
+        size_t same = 0;
+        while (same < common.size() && same < option.size() && common[same] == option[same]) ++same;
+        common.resize(same);
+    }
+    completion.text = common.size() >= word.size() ? common : std::string(word);
+    return completion;
+}
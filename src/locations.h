@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "lineeditor.h"
+#include "session.h"
+#include "threadpool.h"
+
+// One instance running several shops (MirrorBooking --locations north=north.txt,south=south.mbk). Each location
+// is a shard: a Session of its own, with its own store, journal, indexes and rules, and all of them are opened at
+// once on a thread pool at startup. Commands go to the current location; 'location <name>' switches, and
+// 'all slots ...' and 'all display weekly ...' ask every location at the same time and merge the answers.
+// Hours and services are the shop config's, the same everywhere
+class Locations {
+public:
+    struct Store {
+        std::string name;
+        std::string file;
+    };
+
+    // "name=file,..." as stores (a file without a name is named after its stem); false (after reporting it)
+    // if the list is malformed or names a location twice
+    static bool parse(const std::string& list, std::vector<Store>& stores);
+
+    // open every store in parallel; false (after reporting why) if any of them can't be read
+    bool open(const std::vector<Store>& stores, const LoadWindow& window, const std::vector<std::string>& chairs,
+              const SlotRanking& ranking);
+
+    // run one command line at the current location, or across all of them
+    CommandResult execute(const std::string& input, CommandIO& io);
+
+    // what Tab completes: the current location's words, plus location names and the cross-location commands
+    Completion complete(const std::string& line, size_t cursor);
+
+    // make the current location's changes durable (the others haven't changed)
+    void commit() { shards[active]->commit(); }
+
+    // fold every location's journal into its store, in parallel
+    void close();
+
+    std::string prompt() const { return names[active] + "$"; }
+    const std::string& storeName() const { return shards[active]->storeName(); }
+
+private:
+    // "location": list them; "location <name>": switch to it
+    CommandResult locationCommand(const std::string& args, CommandIO& io);
+
+    // "all slots <service> [date] [ranking]": the best free slots at any location
+    CommandResult allSlots(const std::string& args, CommandIO& io);
+
+    // "all display weekly [next|prev]": every location's week in one view
+    CommandResult allWeekly(const std::string& args, CommandIO& io);
+
+    // what a booking or slot at chair resource of location shows as: the location, and the chair if it has several
+    std::string label(size_t location, int resource) const;
+
+    ThreadPool pool;
+    std::vector<std::string> names;
+    std::vector<std::unique_ptr<Session>> shards;
+    size_t active = 0;
+};
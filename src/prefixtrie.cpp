@@ -0,0 +1,172 @@
+#include "prefixtrie.h"
+
+#include <algorithm>
+
+static char fold(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+PrefixTrie::PrefixTrie() : nodes(1) {}
+
+std::uint32_t PrefixTrie::childStarting(std::uint32_t node, char c) const {
+    for (std::uint32_t child = nodes[node].child; child != none; child = nodes[child].sibling) {
+        char first = labels[nodes[child].label];
+        if (first == c) return child;
+        if (static_cast<unsigned char>(first) > static_cast<unsigned char>(c)) break; // sorted
+    }
+    return none;
+}
+
+void PrefixTrie::insert(std::string_view word, int value) {
+    std::uint32_t node = 0;
+    size_t at = 0;
+    while (at < word.size()) {
+        std::uint32_t child = childStarting(node, word[at]);
+        if (child == none) { // nothing shares the rest: it becomes one new edge, in order among its siblings
+            Node leaf;
+            leaf.label = static_cast<std::uint32_t>(labels.size());
+            leaf.length = static_cast<std::uint32_t>(word.size() - at);
+            labels.append(word.substr(at));
+            std::uint32_t added = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back(leaf);
+            std::uint32_t* link = &nodes[node].child;
+            while (*link != none && static_cast<unsigned char>(labels[nodes[*link].label]) < static_cast<unsigned char>(word[at])) {
+                link = &nodes[*link].sibling;
+            }
+            nodes[added].sibling = *link;
+            *link = added;
+            node = added;
+            break;
+        }
+        std::string_view label = edge(nodes[child]);
+        size_t common = 1;
+        while (common < label.size() && at + common < word.size() && label[common] == word[at + common]) ++common;
+        if (common < label.size()) { // word leaves the edge partway: split it, the first part becomes a node of its own
+            Node middle;
+            middle.label = nodes[child].label;
+            middle.length = static_cast<std::uint32_t>(common);
+            middle.child = child;
+            middle.sibling = nodes[child].sibling;
+            middle.words = nodes[child].words;
+            std::uint32_t split = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back(middle);
+            std::uint32_t* link = &nodes[node].child;
+            while (*link != child) link = &nodes[*link].sibling;
+            *link = split;
+            nodes[child].label += static_cast<std::uint32_t>(common);
+            nodes[child].length -= static_cast<std::uint32_t>(common);
+            nodes[child].sibling = none;
+            child = split;
+        }
+        node = child;
+        at += common;
+    }
+    if (nodes[node].uses++ > 0) return;
+    nodes[node].value = value;
+    countPath(word, 1);
+}
+
+std::uint32_t PrefixTrie::locate(std::string_view word) const {
+    std::uint32_t node = 0;
+    size_t at = 0;
+    while (at < word.size()) {
+        node = childStarting(node, word[at]);
+        if (node == none) return none;
+        std::string_view label = edge(nodes[node]);
+        if (word.substr(at, label.size()) != label) return none;
+        at += label.size();
+    }
+    return node;
+}
+
+void PrefixTrie::erase(std::string_view word) {
+    std::uint32_t node = locate(word);
+    if (node == none || nodes[node].uses == 0 || --nodes[node].uses > 0) return;
+    countPath(word, -1); // the nodes stay, for when it comes back
+}
+
+void PrefixTrie::countPath(std::string_view word, int change) {
+    std::uint32_t node = 0;
+    nodes[0].words += change;
+    for (size_t at = 0; at < word.size(); at += nodes[node].length) {
+        node = childStarting(node, word[at]);
+        nodes[node].words += change;
+    }
+}
+
+int PrefixTrie::find(std::string_view word) const {
+    std::uint32_t node = locate(word);
+    return node != none && nodes[node].uses > 0 ? nodes[node].value : -1;
+}
+
+void PrefixTrie::collect(std::uint32_t node, std::string& path, size_t limit, PrefixMatches& matches) const {
+    if (nodes[node].uses > 0 && matches.words.size() < limit) matches.words.push_back(path);
+    for (std::uint32_t child = nodes[node].child; child != none && matches.words.size() < limit; child = nodes[child].sibling) {
+        if (nodes[child].words == 0) continue;
+        size_t length = path.size();
+        path.append(edge(nodes[child]));
+        collect(child, path, limit, matches);
+        path.resize(length);
+    }
+}
+
+std::string PrefixTrie::forced(std::uint32_t node, std::string path) const {
+    while (nodes[node].uses == 0) {
+        std::uint32_t only = none;
+        for (std::uint32_t child = nodes[node].child; child != none; child = nodes[child].sibling) {
+            if (nodes[child].words == 0) continue;
+            if (only != none) return path; // it branches here
+            only = child;
+        }
+        if (only == none) break;
+        path.append(edge(nodes[only]));
+        node = only;
+    }
+    return path;
+}
+
+void PrefixTrie::match(std::uint32_t node, std::string& path, std::string_view rest, bool foldCase, size_t limit,
+                       PrefixMatches& matches, std::vector<std::string>& commons) const {
+    for (std::uint32_t child = nodes[node].child; child != none; child = nodes[child].sibling) {
+        if (nodes[child].words == 0) continue;
+        std::string_view label = edge(nodes[child]);
+        size_t length = std::min(label.size(), rest.size());
+        bool same = foldCase ? std::equal(label.begin(), label.begin() + length, rest.begin(), [](char a, char b) { return fold(a) == fold(b); })
+                             : label.substr(0, length) == rest.substr(0, length);
+        if (!same) continue;
+        size_t before = path.size();
+        path.append(label);
+        if (rest.size() <= label.size()) { // the prefix ends on this edge: everything below matches
+            matches.total += nodes[child].words;
+            commons.push_back(forced(child, path));
+            collect(child, path, limit, matches);
+        } else {
+            match(child, path, rest.substr(label.size()), foldCase, limit, matches, commons);
+        }
+        path.resize(before);
+        if (!foldCase) break; // only one edge starts with a given character
+    }
+}
+
+PrefixMatches PrefixTrie::complete(std::string_view prefix, size_t limit, bool foldCase) const {
+    PrefixMatches matches;
+    std::vector<std::string> commons; // the forced completion of each matching subtree (several when case is folded)
+    std::string path;
+    if (prefix.empty()) {
+        matches.total = nodes[0].words;
+        commons.push_back(forced(0, path));
+        collect(0, path, limit, matches);
+    } else {
+        match(0, path, prefix, foldCase, limit, matches, commons);
+    }
+    if (commons.empty() || matches.total == 0) {
+        matches.common = std::string(prefix);
+        return matches;
+    }
+    matches.common = commons.front();
+    for (const auto& other : commons) {
+        size_t same = 0;
+        while (same < matches.common.size() && same < other.size() && matches.common[same] == other[same]) ++same;
+        matches.common.resize(same);
+    }
+    if (matches.common.size() < prefix.size()) matches.common = std::string(prefix); // spellings differ within the prefix
+    return matches;
+}
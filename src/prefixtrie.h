@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// What a prefix completes to: the longest text every match starts with (the prefix itself if they go
+// separate ways) and the first matches in order
+struct PrefixMatches {
+    std::string common;
+    std::vector<std::string> words;
+    size_t total = 0; // all the matches, words may hold only the first of them
+};
+
+// A radix tree of words, for completion and prefix search. Edges carry whole runs of characters (slices of
+// one shared label buffer) and every node keeps how many words are below it, so a completion walks only the
+// prefix and the matches it returns, however many words there are. Words are counted: adding one again
+// just counts up, and it disappears from completions when erase() brings it back to zero
+class PrefixTrie {
+public:
+    PrefixTrie();
+
+    // add one use of word; value (for find) is set when the word is new
+    void insert(std::string_view word, int value = 0);
+
+    // drop one use of word (nothing happens if it isn't there)
+    void erase(std::string_view word);
+
+    // the value of exactly word, or -1
+    int find(std::string_view word) const;
+
+    // the words that start with prefix (ignoring case if foldCase is set), up to limit of them
+    PrefixMatches complete(std::string_view prefix, size_t limit, bool foldCase = false) const;
+
+    size_t size() const { return nodes[0].words; } // distinct words in use
+
+private:
+    static constexpr std::uint32_t none = 0xffffffffu;
+
+    struct Node {
+        std::uint32_t label = 0;   // the edge into this node is labels[label, label + length)
+        std::uint32_t length = 0;
+        std::uint32_t child = none;   // first child; children are sorted by their first character
+        std::uint32_t sibling = none; // next child of the same parent
+        std::uint32_t uses = 0;  // times the word ending here was inserted and not erased
+        std::uint32_t words = 0; // words in use at or below this node
+        std::int32_t value = -1;
+    };
+
+    // the child of node whose edge starts with c, or none
+    std::uint32_t childStarting(std::uint32_t node, char c) const;
+
+    // add change to the word count of every node on the path down to word (which is in the trie)
+    void countPath(std::string_view word, int change);
+
+    // the node where word ends exactly, or none
+    std::uint32_t locate(std::string_view word) const;
+
+    // every match in the subtree under node (whose word so far is path) into matches, in order
+    void collect(std::uint32_t node, std::string& path, size_t limit, PrefixMatches& matches) const;
+
+    // path extended down the subtree for as long as it has only one way to go
+    std::string forced(std::uint32_t node, std::string path) const;
+
+    // the rest of a prefix matched against the subtree under node (whose word so far is path), case folded or not
+    void match(std::uint32_t node, std::string& path, std::string_view rest, bool foldCase, size_t limit,
+               PrefixMatches& matches, std::vector<std::string>& commons) const;
+
+    std::string_view edge(const Node& node) const { return std::string_view(labels).substr(node.label, node.length); }
+
+    std::vector<Node> nodes; // nodes[0] is the root, with an empty edge
+    std::string labels;      // every edge's characters
+};
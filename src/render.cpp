@@ -0,0 +1,331 @@
+#include "render.h"
+
+#include "config.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+void writeStdout(std::string_view text) {
+    std::cout.flush();
+#ifdef _WIN32
+    std::fwrite(text.data(), 1, text.size(), stdout);
+    std::fflush(stdout);
+#else
+    while (!text.empty()) {
+        ssize_t n = ::write(STDOUT_FILENO, text.data(), text.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        text.remove_prefix(static_cast<size_t>(n));
+    }
+#endif
+}
+
+void showFrame(Frame& frame) {
+    writeStdout(frame.str());
+    frame.clear();
+}
+
+void displayDailySchedule(Frame& frame, const std::vector<Appointment>& appointments, const ScheduleIndex& index, const std::string& date) {
+    std::ostream& out = frame.stream();
+    const DayHours& hours = shopConfig().hoursOn(dateToDays(date)); // open stretches and breaks of this weekday
+    int interval = shopConfig().interval;
+    
+    out << "\n======= Schedule for today: "  << "(" << getDayOfWeek(date) << ") " << formatDateDisplay(date) << " =======\n" << '\n';
+    
+    // get appointments for this date (all chairs), already sorted by time in the index
+    DayBuckets dayAppts = bucketDays(index, dateToDays(date), 1);
+    
+    // Determine the actual display range (include after-hours appointments)
+    bool closed = hours.runs.empty();
+    int displayStart = closed ? minutesPerDay : hours.opens;
+    int displayEnd = closed ? 0 : hours.closes;
+    
+    for (size_t slot : dayAppts.slots) { // adjust display range if there are appointments outside business hours
+        const auto& apt = appointments[slot];
+        int aptStart = apt.start;
+        int aptEnd = aptStart + apt.duration;
+        if (aptStart < displayStart) displayStart = aptStart;
+        if (aptEnd > displayEnd) displayEnd = aptEnd;
+    }
+    
+    // Round to nearest interval
+    displayStart = (displayStart / interval) * interval;
+    displayEnd = ((displayEnd + interval - 1) / interval) * interval;
+    if (displayStart >= displayEnd) { // closed that day and nothing booked after hours
+        out << "[Closed]" << '\n';
+        out << "\n0 appointment(s) scheduled." << '\n';
+        return;
+    }
+    
+    // free time from..to: [available], except for breaks between opening and closing, which show as [break]
+    // (and all of it on a day the shop is closed, where only after-hours bookings are shown)
+    auto showGap = [&](int from, int to) {
+        if (closed) {
+            out << std::setw(11) << std::left << minutesToTime(from) + "-" + minutesToTime(to) << " | " << frame.dim() << "[closed]" << frame.plain() << '\n';
+            return;
+        }
+        auto onBreak = [&](int minute) { return minute >= hours.opens && minute < hours.closes && !hours.isOpen(minute); };
+        while (from < to) {
+            bool breakTime = onBreak(from);
+            int end = from + 1;
+            while (end < to && onBreak(end) == breakTime) ++end;
+            std::string rangeStr = minutesToTime(from) + "-" + minutesToTime(end);
+            out << std::setw(11) << std::left << rangeStr << " | " << frame.dim() << (breakTime ? "[break]" : "[available]") << frame.plain() << '\n';
+            from = end;
+        }
+    };
+    
+    // Display appointments and availability blocks, one timeline per chair when the shop has several
+    int resources = index.resourceCount();
+    for (int r = 0; r < resources; ++r) {
+        if (resources > 1) out << (r > 0 ? "\n" : "") << "--- " << resourceLabel(index, r) << " ---" << '\n';
+        int currentTime = displayStart;
+        const auto* bookings = index.bookingsOn(r, dateToDays(date));
+        size_t count = bookings ? bookings->size() : 0;
+        
+        for (size_t i = 0; i < count; ++i) { // iterate through each appointment
+            const auto& apt = appointments[(*bookings)[i].slot];
+            int aptStart = apt.start;
+            int aptEnd = aptStart + apt.duration;
+            
+            // If there's a gap before this appointment, show availability block
+            if (currentTime < aptStart) showGap(currentTime, aptStart);
+            
+            // Display the appointment
+            std::string timeStr = minutesToTime(aptStart);
+            out << std::setw(11) << std::left << timeStr << " | ";
+            
+            bool isAfterHours = !hours.isOpen(aptStart);
+            if (isAfterHours) {
+                out << frame.warn() << "[OUTSIDE-HOURS] " << frame.plain();
+            } else {
+                out << "[BOOKED] ";
+            }
+            out << frame.paint(apt.kind) << apt.name << " - " << apt.service << frame.plain() << " (" << apt.duration << " min)" << '\n';
+            
+            currentTime = aptEnd; // Move to end of this appointment
+        }
+        
+        // If there's time remaining after the last appointment
+        if (currentTime < displayEnd) showGap(currentTime, displayEnd);
+    }
+    
+    out << "\n" << dayAppts.total() << " appointment(s) scheduled." << '\n';
+}
+
+void displayWeeklySchedule(Frame& frame, const std::vector<Appointment>& appointments, const ScheduleIndex& index, const std::string& startDate) {
+    std::ostream& out = frame.stream();
+    int firstDay = dateToDays(startDate);
+    out << "\n===== Weekly Schedule (" << startDate << " to " 
+              << daysToDate(firstDay + 6) << ") =====\n" << '\n';
+    
+    DayBuckets week = bucketDays(index, firstDay, 7); // one pass for the whole week
+    for (int day = 0; day < 7; ++day) {
+        int targetDay = firstDay + day;
+        std::string currentDate = daysToDate(targetDay);
+        std::string_view dayName = dayOfWeekName(targetDay);
+        
+        out << std::left << std::setw(12) << dayName << " (" << currentDate << "):  ";
+        
+        size_t count = week.countOn(day);
+        if (count == 0) {
+            out << "[No appointments]";
+        } else {
+            // Show appointments in compact format
+            for (size_t i = 0; i < count; ++i) {
+                const auto& apt = appointments[week.slots[week.offsets[day] + i]];
+                if (i > 0) out << " |";
+                out << frame.paint(apt.kind) << apt.time << "-" << apt.name << frame.plain();
+                if (index.resourceCount() > 1) out << "@" << resourceLabel(index, index.findResource(apt.resource));
+            }
+            out << " (" << count << " total)";
+        }
+        
+        out << '\n';
+    }
+    
+    out << "\nNavigation: 'display weekly next' or 'display weekly prev'" << '\n';
+}
+
+void displayMonthlySchedule(Frame& frame, const ScheduleIndex& index, int monthStart) {
+    std::ostream& out = frame.stream();
+    static constexpr std::string_view monthNames[] = {"January", "February", "March", "April", "May", "June", "July",
+                                                      "August", "September", "October", "November", "December"};
+    CivilDate first = civilFromDays(monthStart);
+    int nextMonthStart = first.month == 12 ? daysFromCivil(first.year + 1, 1, 1) : daysFromCivil(first.year, first.month + 1, 1);
+    int dayCount = nextMonthStart - monthStart;
+    
+    out << "\n===== Monthly Schedule: " << monthNames[first.month - 1] << " " << first.year << " =====\n" << '\n';
+    out << "Mon      Tue      Wed      Thu      Fri      Sat      Sun" << '\n';
+    
+    DayBuckets month = bucketDays(index, monthStart, dayCount); // one pass for the whole month
+    int column = (weekdayFromDays(monthStart) + 6) % 7; // Monday = 0
+    out << std::string(static_cast<size_t>(column) * 9, ' ');
+    size_t busiest = 0;
+    int busiestDay = -1;
+    for (int d = 0; d < dayCount; ++d) {
+        size_t count = month.countOn(d);
+        std::string cell = std::to_string(d + 1);
+        if (count > 0) cell += " (" + std::to_string(count) + ")";
+        if (count > busiest) {
+            busiest = count;
+            busiestDay = d;
+        }
+        
+        if (++column == 7 || d + 1 == dayCount) { // last cell on the line doesn't need padding
+            out << cell << '\n';
+            column = 0;
+        } else {
+            out << std::left << std::setw(9) << cell;
+        }
+    }
+    
+    out << "\n" << month.total() << " appointment(s) this month.";
+    if (busiestDay >= 0) {
+        out << " Busiest day: " << dayOfWeekName(monthStart + busiestDay) << " " << daysToDate(monthStart + busiestDay)
+                  << " (" << busiest << ")";
+    }
+    out << '\n';
+    out << "\nNavigation: 'display monthly next' or 'display monthly prev'" << '\n';
+}
+
+// "41.4%" of part in whole (0% when there is nothing to compare with)
+static std::string percent(std::int64_t part, std::int64_t whole) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%.1f%%", whole > 0 ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0);
+    return text;
+}
+
+// "205h 30m", "2h", "45m"
+static std::string hoursAndMinutes(std::int64_t minutes) {
+    if (minutes < 60) return std::to_string(minutes) + "m";
+    std::string text = std::to_string(minutes / 60) + "h";
+    if (minutes % 60) text += " " + std::to_string(minutes % 60) + "m";
+    return text;
+}
+
+// "$3450.00"
+static std::string money(std::int64_t cents) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "$%lld.%02lld", static_cast<long long>(cents / 100), static_cast<long long>(cents % 100));
+    return text;
+}
+
+// share (0..1, more is cut off) as a bar of width characters
+static std::string bar(std::int64_t part, std::int64_t whole, int width = 20) {
+    int filled = whole > 0 ? static_cast<int>(std::min<std::int64_t>(width, (part * width + whole / 2) / whole)) : 0;
+    return std::string(static_cast<size_t>(filled), '#') + std::string(static_cast<size_t>(width - filled), '.');
+}
+
+void displayReport(Frame& frame, const ScheduleReport& report, const ScheduleIndex& index) {
+    std::ostream& out = frame.stream();
+    int days = report.lastDay - report.firstDay + 1;
+    std::int64_t booked = report.booked();
+    std::int64_t open = report.open();
+    out << "\n===== Report " << daysToDate(report.firstDay) << " to " << daysToDate(report.lastDay) << " (" << days
+        << " day" << (days == 1 ? "" : "s") << ") =====\n" << '\n';
+    out << report.appointments() << " appointment(s), " << hoursAndMinutes(booked) << " booked of " << hoursAndMinutes(open)
+        << " open: " << percent(booked, open) << " utilization" << '\n';
+    if (std::int64_t revenue = report.revenue()) out << "Revenue: " << money(revenue) << '\n';
+
+    // per day for a month, then per week, month or year, so a long range still fits on a screen
+    enum class Period { day, week, month, year };
+    Period period = days <= 31 ? Period::day : days <= 26 * 7 ? Period::week : days <= 3 * 366 ? Period::month : Period::year;
+    static constexpr const char* periodNames[] = {"day", "week", "month", "year"};
+    auto periodOf = [period](int day) {
+        CivilDate date = civilFromDays(day);
+        switch (period) {
+            case Period::day: return day;
+            case Period::week: return weekStartFromDays(day);
+            case Period::month: return date.year * 12 + date.month;
+            default: return date.year;
+        }
+    };
+    auto periodLabel = [period](int day) {
+        std::string date = daysToDate(day);
+        switch (period) {
+            case Period::day: return std::string(dayOfWeekName(day)).substr(0, 3) + " " + date;
+            case Period::week: return "week of " + daysToDate(weekStartFromDays(day));
+            case Period::month: return date.substr(0, 7);
+            default: return date.substr(0, 4);
+        }
+    };
+    out << "\nUtilization by " << periodNames[static_cast<int>(period)] << ":" << '\n';
+    for (int d = 0; d < days;) {
+        int key = periodOf(report.firstDay + d);
+        std::int64_t periodBooked = 0, periodOpen = 0, periodCount = 0;
+        int from = d;
+        for (; d < days && periodOf(report.firstDay + d) == key; ++d) {
+            periodBooked += report.bookedByDay[d];
+            periodOpen += report.openByDay[d];
+            periodCount += report.countByDay[d];
+        }
+        out << "  " << std::left << std::setw(20) << periodLabel(report.firstDay + from) << bar(periodBooked, periodOpen) << "  "
+            << std::right << std::setw(6) << percent(periodBooked, periodOpen) << "  " << periodCount << " appt(s)" << '\n';
+    }
+
+    if (report.chairs > 1) {
+        out << "\nUtilization by chair:" << '\n';
+        std::int64_t chairOpen = open / report.chairs;
+        for (int r = 0; r < report.chairs; ++r) {
+            out << "  " << std::left << std::setw(20) << resourceLabel(index, r) << bar(report.bookedByChair[r], chairOpen) << "  "
+                << std::right << std::setw(6) << percent(report.bookedByChair[r], chairOpen) << '\n';
+        }
+    }
+
+    if (days >= 7) {
+        std::array<std::int64_t, 7> weekdayBooked{}, weekdayOpen{};
+        for (int d = 0; d < days; ++d) {
+            int weekday = weekdayFromDays(report.firstDay + d);
+            weekdayBooked[weekday] += report.bookedByDay[d];
+            weekdayOpen[weekday] += report.openByDay[d];
+        }
+        out << "\nUtilization by weekday:" << '\n';
+        for (int i = 0; i < 7; ++i) {
+            int weekday = (i + 1) % 7; // Monday first
+            if (weekdayOpen[weekday] == 0 && weekdayBooked[weekday] == 0) continue;
+            out << "  " << std::left << std::setw(20) << dayOfWeekName(3 + weekday) // day 3, 1970-01-04, was a Sunday
+                << bar(weekdayBooked[weekday], weekdayOpen[weekday]) << "  " << std::right << std::setw(6)
+                << percent(weekdayBooked[weekday], weekdayOpen[weekday]) << '\n';
+        }
+    }
+
+    out << "\nBusiest hours:" << '\n';
+    int busiest = -1;
+    for (int hour = 0; hour < 24; ++hour) {
+        if (report.openByHour[hour] == 0 && report.bookedByHour[hour] == 0) continue;
+        if (busiest < 0 || report.bookedByHour[hour] * report.openByHour[busiest] > report.bookedByHour[busiest] * report.openByHour[hour]) {
+            busiest = hour;
+        }
+        out << "  " << std::left << std::setw(20) << minutesToTime(hour * 60) + "-" + minutesToTime((hour + 1) * 60 % minutesPerDay)
+            << bar(report.bookedByHour[hour], report.openByHour[hour]) << "  " << std::right << std::setw(6)
+            << percent(report.bookedByHour[hour], report.openByHour[hour]) << '\n';
+    }
+    if (busiest >= 0) out << "  Busiest: " << minutesToTime(busiest * 60) << "-" << minutesToTime((busiest + 1) * 60 % minutesPerDay) << '\n';
+
+    out << "\nService mix:" << '\n';
+    std::int64_t count = report.appointments();
+    for (size_t s = 0; s < report.services.size(); ++s) {
+        if (report.serviceCount[s] == 0) continue;
+        out << "  " << std::left << std::setw(12) << report.services[s] << std::right << std::setw(8) << report.serviceCount[s]
+            << std::setw(8) << percent(report.serviceCount[s], count) << std::setw(12) << hoursAndMinutes(report.serviceMinutes[s]);
+        if (report.serviceRevenue[s]) out << std::setw(14) << money(report.serviceRevenue[s]);
+        out << '\n';
+    }
+    if (count == 0) out << "  [No appointments]" << '\n';
+
+    out << "\nNo-gap ratio: " << percent(report.backToBack, report.neighbours) << " of consecutive bookings on a chair are back to back ("
+        << report.backToBack << " of " << report.neighbours << ")" << '\n';
+    out << "Idle between bookings: " << hoursAndMinutes(report.idleMinutes) << ", " << hoursAndMinutes(report.deadMinutes)
+        << " of it in gaps too short for any service (under " << shopConfig().services.shortest() << " min)" << '\n';
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "appointment.h"
+#include "report.h"
+#include "schedule.h"
+
+// One rendered view. Everything is composed into a preallocated string through a std::ostream
+// and written out with a single write() when the frame is shown, instead of a flush per line
+class Frame : private std::streambuf {
+public:
+    explicit Frame(size_t capacity = 16 * 1024) : out(this) { text.reserve(capacity); }
+    
+    std::ostream& stream() { return out; }
+    const std::string& str() const { return text; }
+    void clear() { text.clear(); }
+    
+    // ANSI colour for a service type, or "" when colour is off
+    const char* paint(ServiceType kind) const {
+        if (!color) return "";
+        switch (kind) {
+            case ServiceType::hair: return "\x1b[36m";  // cyan
+            case ServiceType::beard: return "\x1b[33m"; // yellow
+            case ServiceType::full: return "\x1b[35m";  // magenta
+            default: return "\x1b[32m";                 // green
+        }
+    }
+    const char* warn() const { return color ? "\x1b[31m" : ""; }
+    const char* dim() const { return color ? "\x1b[2m" : ""; }
+    const char* plain() const { return color ? "\x1b[0m" : ""; }
+    
+    bool color = false;
+    
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) text.push_back(traits_type::to_char_type(ch));
+        return traits_type::not_eof(ch);
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        text.append(s, static_cast<size_t>(n));
+        return n;
+    }
+    
+private:
+    std::string text;
+    std::ostream out;
+};
+
+// Write a block of text to stdout in one go, after anything still sitting in std::cout's buffer
+void writeStdout(std::string_view text);
+
+// Show a frame and empty it for the next view
+void showFrame(Frame& frame);
+
+// Turns a sequence of full frames into terminal updates for a screen that shows nothing else (the mirror).
+// The first frame clears the screen; after that only lines that changed are rewritten in place
+class FrameDiff {
+public:
+    std::string update(const std::string& frame) {
+        std::vector<std::string> lines = splitLines(frame);
+        std::string patch;
+        patch.reserve(frame.size() + 64);
+        if (!started) {
+            patch += "\x1b[2J";
+            started = true;
+        }
+        size_t rows = std::max(lines.size(), shown.size());
+        for (size_t row = 0; row < rows; ++row) {
+            bool had = row < shown.size();
+            bool has = row < lines.size();
+            if (had && has && shown[row] == lines[row]) continue;
+            patch += "\x1b[" + std::to_string(row + 1) + ";1H"; // cursor to the start of the row
+            if (has) patch += lines[row];
+            patch += "\x1b[K"; // erase whatever the old line left behind
+        }
+        if (!patch.empty()) patch += "\x1b[" + std::to_string(lines.size() + 1) + ";1H"; // park the cursor below the view
+        shown = std::move(lines);
+        return patch;
+    }
+    
+private:
+    static std::vector<std::string> splitLines(const std::string& text) {
+        std::vector<std::string> lines;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t nl = text.find('\n', pos);
+            if (nl == std::string::npos) nl = text.size();
+            lines.emplace_back(text, pos, nl - pos);
+            pos = nl + 1;
+        }
+        return lines;
+    }
+    
+    std::vector<std::string> shown;
+    bool started = false;
+};
+
+// Display daily schedule
+void displayDailySchedule(Frame& frame, const std::vector<Appointment>& appointments, const ScheduleIndex& index, const std::string& date);
+
+// Display weekly schedule
+void displayWeeklySchedule(Frame& frame, const std::vector<Appointment>& appointments, const ScheduleIndex& index, const std::string& startDate);
+
+// Display monthly schedule as a Monday-first calendar grid with the number of appointments per day
+// monthStart is the day number of the 1st of the month
+void displayMonthlySchedule(Frame& frame, const ScheduleIndex& index, int monthStart);
+
+// Display a report: totals, utilization per day, week, month or year (whichever suits the length of the range),
+// per chair, per weekday and per hour, the service mix and how tightly the bookings are packed
+void displayReport(Frame& frame, const ScheduleReport& report, const ScheduleIndex& index);
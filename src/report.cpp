@@ -0,0 +1,225 @@
+#include "report.h"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+std::int64_t ScheduleReport::booked() const {
+    return std::accumulate(bookedByDay.begin(), bookedByDay.end(), std::int64_t(0));
+}
+
+std::int64_t ScheduleReport::open() const {
+    return std::accumulate(openByDay.begin(), openByDay.end(), std::int64_t(0));
+}
+
+std::int64_t ScheduleReport::appointments() const {
+    return std::accumulate(countByDay.begin(), countByDay.end(), std::int64_t(0));
+}
+
+std::int64_t ScheduleReport::revenue() const {
+    return std::accumulate(serviceRevenue.begin(), serviceRevenue.end(), std::int64_t(0));
+}
+
+namespace {
+// One block's share of the figures that aren't kept per day (those go straight into the report, since the
+// blocks' days don't overlap)
+struct Partial {
+    Partial(size_t chairs, size_t services) : bookedByChair(chairs), serviceCount(services), serviceMinutes(services) {}
+
+    std::vector<std::int64_t> bookedByChair;
+    std::vector<std::int64_t> serviceCount;
+    std::vector<std::int64_t> serviceMinutes;
+    std::array<std::int64_t, 24> bookedByHour{};
+    std::int64_t neighbours = 0;
+    std::int64_t backToBack = 0;
+    std::int64_t idleMinutes = 0;
+    std::int64_t deadMinutes = 0;
+};
+
+// Which report row a service name is counted in: the catalog entry's (an alias counts with the service it
+// names), or the last row for custom minutes and names the catalog doesn't know
+class ServiceRows {
+public:
+    ServiceRows(const ServiceCatalog& catalog, ScheduleReport& report) : catalog(catalog) {
+        const auto& list = catalog.list();
+        for (const auto& service : list) {
+            if (!service.alias) {
+                report.services.push_back(service.name);
+                prices.push_back(service.price);
+            }
+            rows.push_back(static_cast<std::uint16_t>(report.services.size() - 1));
+        }
+        other = static_cast<std::uint16_t>(report.services.size());
+        report.services.push_back("other");
+        prices.push_back(0);
+    }
+
+    std::uint16_t of(std::string_view name) const {
+        const ServiceCatalog::Service* service = catalog.find(name);
+        return service ? rows[static_cast<size_t>(service - catalog.list().data())] : other;
+    }
+
+    int price(size_t row) const { return prices[row]; }
+
+private:
+    const ServiceCatalog& catalog;
+    std::vector<std::uint16_t> rows; // catalog entry -> report row
+    std::vector<int> prices;         // report row -> cents
+    std::uint16_t other = 0;
+};
+
+// the bookings of days first..last as columns: the stored ones day by day and chair by chair (already in order),
+// then the recurring occurrences, which are sorted in among them
+void collect(const std::vector<Appointment>& appointments, const ScheduleIndex& index,
+             const std::vector<RecurrenceRule>& rules, const ServiceRows& services, int first, int last,
+             BookingColumns& columns) {
+    int chairs = index.resourceCount();
+    for (int day = first; day <= last; ++day) {
+        for (int r = 0; r < chairs; ++r) {
+            const auto* bookings = index.bookingsOn(r, day);
+            if (!bookings) continue;
+            for (const auto& b : *bookings) {
+                const Appointment& apt = appointments[b.slot];
+                columns.push(day, apt.start, apt.duration, r, services.of(apt.service));
+            }
+        }
+    }
+    size_t stored = columns.size();
+    for (const auto& rule : rules) {
+        const Appointment& pattern = rule.pattern;
+        int chair = std::max(0, index.findResource(pattern.resource));
+        std::uint16_t service = services.of(pattern.service);
+        rule.forEachOccurrence(first, last, [&](int day) { columns.push(day, pattern.start, pattern.duration, chair, service); });
+    }
+    if (columns.size() == stored) return;
+
+    std::vector<std::uint32_t> order(columns.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&columns](std::uint32_t a, std::uint32_t b) {
+        return std::tie(columns.day[a], columns.chair[a], columns.start[a]) < std::tie(columns.day[b], columns.chair[b], columns.start[b]);
+    });
+    BookingColumns sorted;
+    for (std::uint32_t row : order) {
+        sorted.push(columns.day[row], columns.start[row], columns.duration[row], columns.chair[row], columns.service[row]);
+    }
+    columns = std::move(sorted);
+}
+
+// add one block's columns into the report's per-day figures (from day first on) and into its partial
+void aggregate(const BookingColumns& columns, int first, int shortest, ScheduleReport& report, Partial& partial) {
+    const size_t n = columns.size();
+    const std::int32_t* day = columns.day.data();
+    const std::int32_t* start = columns.start.data();
+    const std::int32_t* duration = columns.duration.data();
+    const std::uint16_t* chair = columns.chair.data();
+    const std::uint16_t* service = columns.service.data();
+
+    std::int64_t* bookedByDay = report.bookedByDay.data() + (first - report.firstDay);
+    std::int32_t* countByDay = report.countByDay.data() + (first - report.firstDay);
+    for (size_t i = 0; i < n; ++i) {
+        bookedByDay[day[i] - first] += duration[i];
+        countByDay[day[i] - first] += 1;
+    }
+    for (size_t i = 0; i < n; ++i) partial.bookedByChair[chair[i]] += duration[i];
+    for (size_t i = 0; i < n; ++i) {
+        partial.serviceCount[service[i]] += 1;
+        partial.serviceMinutes[service[i]] += duration[i];
+    }
+    for (size_t i = 0; i < n; ++i) { // a booking spans one or two hours, rarely more
+        int from = start[i];
+        int to = from + duration[i];
+        for (int hour = from / 60; hour < 24 && hour * 60 < to; ++hour) {
+            partial.bookedByHour[hour] += std::min(to, (hour + 1) * 60) - std::max(from, hour * 60);
+        }
+    }
+
+    // gaps between each row and the one before it, counted only when both are on the same chair and day;
+    // written without branches so it runs as straight vector code
+    std::int64_t neighbours = 0, backToBack = 0, idle = 0, dead = 0;
+    for (size_t i = 1; i < n; ++i) {
+        std::int32_t gap = start[i] - (start[i - 1] + duration[i - 1]);
+        std::int32_t same = (day[i] == day[i - 1]) & (chair[i] == chair[i - 1]);
+        std::int32_t waiting = same * std::max(gap, 0);
+        neighbours += same;
+        backToBack += same & (gap <= 0);
+        idle += waiting;
+        dead += waiting * (waiting < shortest);
+    }
+    partial.neighbours += neighbours;
+    partial.backToBack += backToBack;
+    partial.idleMinutes += idle;
+    partial.deadMinutes += dead;
+}
+} // namespace
+
+ScheduleReport buildReport(const std::vector<Appointment>& appointments, const ScheduleIndex& index,
+                           const std::vector<RecurrenceRule>& rules, const ShopConfig& config, int first, int last,
+                           ThreadPool* pool) {
+    ScheduleReport report;
+    report.firstDay = first;
+    report.lastDay = last;
+    report.chairs = index.resourceCount();
+    size_t days = static_cast<size_t>(last - first) + 1;
+    report.bookedByDay.assign(days, 0);
+    report.openByDay.assign(days, 0);
+    report.countByDay.assign(days, 0);
+    ServiceRows services(config.services, report);
+
+    // open minutes in each hour of each weekday; a day's open time only depends on its weekday
+    std::array<std::array<std::int64_t, 24>, 7> openHours{};
+    std::array<std::int64_t, 7> openDay{};
+    for (int weekday = 0; weekday < 7; ++weekday) {
+        for (const auto& run : config.week[weekday].runs) {
+            for (int minute = run.first; minute < run.second; ++minute) openHours[weekday][minute / 60] += report.chairs;
+        }
+        openDay[weekday] = std::accumulate(openHours[weekday].begin(), openHours[weekday].end(), std::int64_t(0));
+    }
+    std::array<std::int64_t, 7> weekdays{}; // how often each weekday comes up in the range
+    for (size_t d = 0; d < days; ++d) {
+        int weekday = weekdayFromDays(first + static_cast<int>(d));
+        report.openByDay[d] = openDay[weekday];
+        ++weekdays[weekday];
+    }
+    for (int weekday = 0; weekday < 7; ++weekday) {
+        for (int hour = 0; hour < 24; ++hour) report.openByHour[hour] += weekdays[weekday] * openHours[weekday][hour];
+    }
+
+    // a few blocks per worker, so one busy stretch doesn't keep the rest waiting; at least a month each, since a
+    // short report is over before handing it out would pay off
+    constexpr size_t blockDays = 31;
+    size_t workers = pool ? pool->size() : 1;
+    size_t blocks = std::max<size_t>(1, std::min(days / blockDays, workers * 4));
+    std::vector<Partial> partials(blocks, Partial(static_cast<size_t>(report.chairs), report.services.size()));
+    int shortest = config.services.shortest();
+    auto runBlock = [&](size_t block) {
+        int from = first + static_cast<int>(days * block / blocks);
+        int to = first + static_cast<int>(days * (block + 1) / blocks) - 1;
+        BookingColumns columns;
+        collect(appointments, index, rules, services, from, to, columns);
+        if (columns.size() > 0) aggregate(columns, from, shortest, report, partials[block]);
+    };
+    if (pool && blocks > 1) {
+        pool->forEach(blocks, runBlock);
+    } else {
+        for (size_t block = 0; block < blocks; ++block) runBlock(block);
+    }
+
+    report.bookedByChair.assign(static_cast<size_t>(report.chairs), 0);
+    report.serviceCount.assign(report.services.size(), 0);
+    report.serviceMinutes.assign(report.services.size(), 0);
+    for (const auto& partial : partials) {
+        for (size_t r = 0; r < partial.bookedByChair.size(); ++r) report.bookedByChair[r] += partial.bookedByChair[r];
+        for (size_t s = 0; s < partial.serviceCount.size(); ++s) {
+            report.serviceCount[s] += partial.serviceCount[s];
+            report.serviceMinutes[s] += partial.serviceMinutes[s];
+        }
+        for (int hour = 0; hour < 24; ++hour) report.bookedByHour[hour] += partial.bookedByHour[hour];
+        report.neighbours += partial.neighbours;
+        report.backToBack += partial.backToBack;
+        report.idleMinutes += partial.idleMinutes;
+        report.deadMinutes += partial.deadMinutes;
+    }
+    report.serviceRevenue.resize(report.services.size());
+    for (size_t s = 0; s < report.services.size(); ++s) report.serviceRevenue[s] = report.serviceCount[s] * services.price(s);
+    return report;
+}
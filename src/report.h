@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "appointment.h"
+#include "config.h"
+#include "schedule.h"
+#include "threadpool.h"
+
+// What the owner wants to know about a run of days: how full the chairs were, when the shop is busiest, what was
+// booked (and what it brought in, for services with a price) and how tightly the bookings sit together.
+// Recurring occurrences count like any other booking. Minutes are chair-minutes: two chairs open 8 hours are
+// 960 open minutes
+struct ScheduleReport {
+    int firstDay = 0;
+    int lastDay = 0;
+    int chairs = 1;
+    std::vector<std::int64_t> bookedByDay; // one entry per day of the range
+    std::vector<std::int64_t> openByDay;   // the configured hours, times the chairs
+    std::vector<std::int32_t> countByDay;  // appointments
+    std::vector<std::int64_t> bookedByChair;
+    std::array<std::int64_t, 24> bookedByHour{}; // booked minutes falling within each hour of the day
+    std::array<std::int64_t, 24> openByHour{};
+    std::vector<std::string> services;           // the catalog's services (aliases counted with them), then "other"
+    std::vector<std::int64_t> serviceCount;
+    std::vector<std::int64_t> serviceMinutes;
+    std::vector<std::int64_t> serviceRevenue;    // in cents
+    std::int64_t neighbours = 0;  // pairs of consecutive bookings on the same chair and day
+    std::int64_t backToBack = 0;  // of those, the ones with no gap between them
+    std::int64_t idleMinutes = 0; // in the gaps between neighbours
+    std::int64_t deadMinutes = 0; // in gaps too short for the shortest service, which can never be sold
+
+    std::int64_t booked() const;
+    std::int64_t open() const;
+    std::int64_t appointments() const;
+    std::int64_t revenue() const;
+};
+
+// The bookings of some days as columns (struct of arrays), in (day, chair, start) order. Every figure of the report
+// is one pass over the one or two columns it needs, so the loops stay tight and the compiler can vectorize them
+struct BookingColumns {
+    std::vector<std::int32_t> day;
+    std::vector<std::int32_t> start;    // minutes since midnight
+    std::vector<std::int32_t> duration;
+    std::vector<std::uint16_t> chair;
+    std::vector<std::uint16_t> service; // position in ScheduleReport::services
+
+    size_t size() const { return day.size(); }
+    void push(int d, int s, int minutes, int resource, int kind) {
+        day.push_back(d);
+        start.push_back(s);
+        duration.push_back(minutes);
+        chair.push_back(static_cast<std::uint16_t>(resource));
+        service.push_back(static_cast<std::uint16_t>(kind));
+    }
+};
+
+// The report for days first..last. The days are cut into blocks that are turned into columns and aggregated
+// side by side on pool (on the calling thread without one), and the blocks' figures are added up at the end.
+// The days must be paged in
+ScheduleReport buildReport(const std::vector<Appointment>& appointments, const ScheduleIndex& index,
+                           const std::vector<RecurrenceRule>& rules, const ShopConfig& config, int first, int last,
+                           ThreadPool* pool = nullptr);
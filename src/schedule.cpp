@@ -0,0 +1,200 @@
+#include "schedule.h"
+
+#include "config.h"
+
+DayBuckets bucketDays(const ScheduleIndex& index, int firstDay, int dayCount) {
+    DayBuckets buckets;
+    buckets.firstDay = firstDay;
+    buckets.offsets.assign(static_cast<size_t>(dayCount) + 1, 0);
+    int resources = index.resourceCount();
+    for (int d = 0; d < dayCount; ++d) { // sizes first, so slots is allocated exactly once
+        size_t count = 0;
+        for (int r = 0; r < resources; ++r) {
+            if (const auto* day = index.bookingsOn(r, firstDay + d)) count += day->size();
+        }
+        buckets.offsets[d + 1] = buckets.offsets[d] + count;
+    }
+    buckets.slots.reserve(buckets.offsets[dayCount]);
+    std::vector<BookedInterval> merged; // one day across all resources, re-sorted by start
+    for (int d = 0; d < dayCount; ++d) {
+        merged.clear();
+        for (int r = 0; r < resources; ++r) {
+            if (const auto* day = index.bookingsOn(r, firstDay + d)) merged.insert(merged.end(), day->begin(), day->end());
+        }
+        if (resources > 1) {
+            std::stable_sort(merged.begin(), merged.end(), [](const BookedInterval& a, const BookedInterval& b) { return a.start < b.start; });
+        }
+        for (const auto& b : merged) buckets.slots.push_back(b.slot);
+    }
+    return buckets;
+}
+
+std::string resourceLabel(const ScheduleIndex& index, int resource) {
+    std::string_view name = index.resourceName(resource);
+    if (name.empty()) return "Main chair";
+    bool numbered = std::all_of(name.begin(), name.end(), [](char c) { return c >= '0' && c <= '9'; });
+    return numbered ? "Chair " + std::string(name) : std::string(name); // "--chairs 4" names them 1-4
+}
+
+// the first minute on the slot grid of an open stretch starting at runStart that is at or after minute
+static int snapToGrid(int minute, int runStart, int interval) {
+    return minute <= runStart ? runStart : runStart + (minute - runStart + interval - 1) / interval * interval;
+}
+
+std::string findNextAvailableTime(const ScheduleIndex& index, std::string_view date, int duration,
+                                  bool adminOverride, int* resource, int onlyResource) {
+    const ShopConfig& config = shopConfig();
+    int interval = config.interval; // check every interval minutes
+    int day = dateToDays(date);
+    
+    // get current time if booking for today
+    int earliest = day == getCurrentDay() ? getCurrentTimeInMinutes() : 0;
+    
+    int first = onlyResource >= 0 ? onlyResource : 0;
+    int last = onlyResource >= 0 ? onlyResource : index.resourceCount() - 1;
+    for (const auto& run : config.hoursOn(day).bookable(adminOverride)) { // open stretches between breaks, in order
+        if (run.second <= earliest) continue;
+        int startTime = snapToGrid(earliest, run.first, interval);
+        int slot = -1;
+        for (int r = first; r <= last && slot != startTime; ++r) { // nothing beats startTime itself
+            int candidate = index.findFreeSlot(r, day, startTime, run.second, duration, interval);
+            if (candidate >= 0 && (slot < 0 || candidate < slot)) {
+                slot = candidate;
+                if (resource) *resource = r;
+            }
+        }
+        if (slot >= 0) return minutesToTime(slot);
+    }
+    return ""; // no available slot available
+}
+
+bool SlotRanking::parse(std::string_view text) {
+    if (text == "earliest") {
+        order = Order::earliest;
+    } else if (text == "fit") {
+        order = Order::fit;
+    } else {
+        size_t dash = text.find('-');
+        if (dash == std::string_view::npos || dash == 0 || dash + 1 == text.size()) return false;
+        int from = timeToMinutes(text.substr(0, dash));
+        int to = timeToMinutes(text.substr(dash + 1));
+        if (to <= from) return false;
+        order = Order::preferred;
+        preferredStart = from;
+        preferredEnd = to;
+    }
+    return true;
+}
+
+std::string SlotRanking::describe() const {
+    switch (order) {
+        case Order::earliest: return "earliest";
+        case Order::fit: return "best fit";
+        case Order::preferred: return "closest to " + minutesToTime(preferredStart) + "-" + minutesToTime(preferredEnd);
+    }
+    return "";
+}
+
+// penalty of booking [start, start + duration) in the free gap [gapStart, gapEnd)
+static int slotPenalty(const SlotRanking& ranking, int start, int duration, int gapStart, int gapEnd, int shortest) {
+    switch (ranking.order) {
+        case SlotRanking::Order::earliest:
+            return 0;
+        case SlotRanking::Order::fit: {
+            // holes it leaves: ones too short for even the shortest service are dead time, and every hole splits the day
+            int before = start - gapStart;
+            int after = gapEnd - (start + duration);
+            int dead = (before > 0 && before < shortest ? before : 0) + (after > 0 && after < shortest ? after : 0);
+            int holes = (before > 0) + (after > 0);
+            return dead * 10000 + holes * 1000 + (gapEnd - gapStart - duration); // then the tightest gap
+        }
+        case SlotRanking::Order::preferred:
+            return std::max(0, ranking.preferredStart - start) + std::max(0, start + duration - ranking.preferredEnd);
+    }
+    return 0;
+}
+
+std::vector<SlotCandidate> findBestSlots(const ScheduleIndex& index, const SlotSearch& search) {
+    const ShopConfig& config = shopConfig();
+    const int interval = config.interval;
+    const int shortest = config.services.shortest();
+    auto better = [](const SlotCandidate& a, const SlotCandidate& b) { return a.before(b); };
+    
+    std::vector<SlotCandidate> found;
+    std::vector<SlotCandidate> onDay;
+    int today = getCurrentDay();
+    int firstResource = search.onlyResource >= 0 ? search.onlyResource : 0;
+    int lastResource = search.onlyResource >= 0 ? search.onlyResource : index.resourceCount() - 1;
+    for (int day = std::max(search.firstDay, today); day < search.firstDay + search.days; ++day) {
+        // earliest order: every slot on a later day ranks below the ones we already have
+        if (search.ranking.order == SlotRanking::Order::earliest && found.size() >= search.count) break;
+        int earliest = day == today ? getCurrentTimeInMinutes() : 0;
+        
+        onDay.clear();
+        for (const auto& run : config.hoursOn(day).bookable(search.adminOverride)) { // open stretches between breaks
+            if (run.second <= earliest) continue;
+            int open = std::max(run.first, earliest);
+            int close = run.second;
+            for (int r = firstResource; r <= lastResource; ++r) {
+                const auto* bookings = index.bookingsOn(r, day);
+                size_t next = 0;
+                int gapStart = open;
+                while (gapStart < close) { // walk the free gaps between the bookings
+                    int gapEnd = close;
+                    int resume = close;
+                    for (; bookings && next < bookings->size(); ++next) {
+                        const BookedInterval& b = (*bookings)[next];
+                        if (b.end <= gapStart) continue;
+                        if (b.start > gapStart) {
+                            gapEnd = std::min(b.start, close);
+                            resume = b.end;
+                            break;
+                        }
+                        gapStart = b.end; // booked right now, the gap starts after it
+                    }
+                    if (gapStart >= close) break;
+                    for (int start = snapToGrid(gapStart, run.first, interval); start + search.duration <= gapEnd; start += interval) {
+                        int penalty = slotPenalty(search.ranking, start, search.duration, gapStart, gapEnd, shortest);
+                        onDay.push_back(SlotCandidate{day, start, r, penalty});
+                    }
+                    gapStart = resume;
+                }
+            }
+        }
+        std::sort(onDay.begin(), onDay.end(), better);
+        if (search.perDay > 0 && onDay.size() > search.perDay) onDay.resize(search.perDay);
+        found.insert(found.end(), onDay.begin(), onDay.end());
+    }
+    size_t keep = std::min(found.size(), search.count);
+    std::partial_sort(found.begin(), found.begin() + keep, found.end(), better);
+    found.resize(keep);
+    return found;
+}
+
+size_t addAppointment(std::vector<Appointment>& appointments, ScheduleIndex& index, const Appointment& apt,
+                      std::vector<size_t>& freeSlots) {
+    size_t slot;
+    if (freeSlots.empty()) {
+        slot = appointments.size();
+        appointments.push_back(apt);
+    } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        appointments[slot] = apt;
+    }
+    index.insert(apt, slot);
+    return slot;
+}
+
+void removeAppointment(std::vector<Appointment>& appointments, ScheduleIndex& index, size_t slot,
+                       std::vector<size_t>& freeSlots) {
+    index.unlink(appointments[slot], slot);
+    freeSlots.push_back(slot);
+}
+
+const Appointment* findConflict(const std::vector<Appointment>& appointments, const ScheduleIndex& index, const Appointment& apt) {
+    int resource = index.findResource(apt.resource);
+    if (resource < 0) return nullptr; // a chair nobody is booked on yet
+    const BookedInterval* hit = index.findOverlap(resource, apt.day, apt.start, apt.start + apt.duration);
+    return hit ? &appointments[hit->slot] : nullptr;
+}
@@ -0,0 +1,449 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "appointment.h"
+#include "calendar.h"
+#include "prefixtrie.h"
+
+// A booked block of time on one date, as stored in the schedule index
+struct BookedInterval {
+    int start;   // minutes since midnight
+    int end;     // start + duration
+    size_t slot; // position of the appointment in the appointments vector
+};
+
+// Per-resource, per-date index of booked intervals, kept sorted by start time.
+// Each chair/barber (resource) has its own timeline: overlap checks and slot searches only ever look at
+// the intervals of one resource on one date, so they cost O(its appointments that day) instead of
+// O(entire history). Resources get small ids in the order they are registered or first seen; an
+// appointment with no resource belongs to resource 0, the shop's first chair
+class ScheduleIndex {
+public:
+    static constexpr size_t noSlot = static_cast<size_t>(-1);
+
+    // rebuild the whole index from the appointments vector (used after loading); resources are kept
+    void build(const std::vector<Appointment>& appointments) {
+        days.clear();
+        insertFrom(appointments, 0);
+    }
+    
+    // index appointments[from..] in one go (a load, or a range paged in). Their (resource, day) buckets are
+    // counted first, so the table and every bucket's vector are allocated once at their final size instead of
+    // growing booking by booking. Bookings spread too thinly over the calendar for a dense count (a handful
+    // over decades) are just inserted one by one
+    void insertFrom(const std::vector<Appointment>& appointments, size_t from) {
+        if (from >= appointments.size()) return;
+        const size_t n = appointments.size() - from;
+        std::vector<int> chair(n);
+        int first = std::numeric_limits<int>::max(), last = std::numeric_limits<int>::min();
+        for (size_t i = 0; i < n; ++i) {
+            const Appointment& apt = appointments[from + i];
+            chair[i] = resourceId(apt.resource);
+            first = std::min(first, apt.day);
+            last = std::max(last, apt.day);
+        }
+        const size_t span = static_cast<size_t>(static_cast<std::int64_t>(last) - first) + 1;
+        const size_t chairs = static_cast<size_t>(resourceCount());
+        if (span > (n * 4 + 1024) / chairs) {
+            for (size_t i = 0; i < n; ++i) place(appointments[from + i], from + i, chair[i]);
+            return;
+        }
+        
+        std::vector<std::uint32_t> counts(chairs * span, 0); // (chair, day - first) -> bookings
+        for (size_t i = 0; i < n; ++i) ++counts[static_cast<size_t>(chair[i]) * span + (appointments[from + i].day - first)];
+        days.reserve(days.size() + static_cast<size_t>(std::count_if(counts.begin(), counts.end(), [](std::uint32_t c) { return c > 0; })));
+        for (size_t cell = 0; cell < counts.size(); ++cell) {
+            if (counts[cell] == 0) continue;
+            auto& day = days[key(static_cast<int>(cell / span), first + static_cast<int>(cell % span))];
+            day.reserve(day.size() + counts[cell]);
+        }
+        for (size_t i = 0; i < n; ++i) place(appointments[from + i], from + i, chair[i]);
+    }
+
+    // register a configured resource; the first one registered becomes id 0, the chair unassigned bookings use
+    void addResource(std::string_view name) {
+        if (resources.empty()) {
+            resources.emplace_back(name);
+        } else if (findResource(name) < 0) {
+            resources.emplace_back(name);
+        }
+    }
+
+    // id of a resource, registering it if it is new
+    int resourceId(std::string_view name) {
+        int id = findResource(name);
+        if (id >= 0) return id;
+        if (resources.empty() && !name.empty()) resources.emplace_back(); // keep id 0 for unassigned bookings
+        resources.emplace_back(name);
+        return static_cast<int>(resources.size()) - 1;
+    }
+    
+    // id of a known resource, or -1
+    int findResource(std::string_view name) const {
+        if (name.empty()) return 0;
+        for (size_t id = 0; id < resources.size(); ++id) {
+            if (resources[id] == name) return static_cast<int>(id);
+        }
+        return -1;
+    }
+    
+    int resourceCount() const { return resources.empty() ? 1 : static_cast<int>(resources.size()); }
+    std::string_view resourceName(int id) const { return resources.empty() ? std::string_view() : resources[id]; }
+
+    // index an appointment stored at appointments[slot] (must already be normalized)
+    void insert(const Appointment& apt, size_t slot) { place(apt, slot, resourceId(apt.resource)); }
+
+    // drop the appointment at appointments[slot] without touching any other slot numbers
+    void unlink(const Appointment& apt, size_t slot) {
+        auto found = days.find(key(findResource(apt.resource), apt.day));
+        if (found != days.end()) {
+            auto& day = found->second;
+            day.erase(std::remove_if(day.begin(), day.end(),
+                [slot](const BookedInterval& b) { return b.slot == slot; }), day.end());
+            if (day.empty()) days.erase(found);
+        }
+    }
+
+    // first booked interval of resource on date overlapping [start, end), or nullptr if the range is free
+    const BookedInterval* findOverlap(int resource, int day, int start, int end) const {
+        auto found = days.find(key(resource, day));
+        if (found == days.end()) return nullptr;
+        for (const auto& b : found->second) {
+            if (b.start >= end) break; // sorted by start, nothing later can overlap
+            if (start < b.end) return &b;
+        }
+        return nullptr;
+    }
+
+    // all bookings of resource on a day sorted by start, or nullptr if it has none
+    const std::vector<BookedInterval>* bookingsOn(int resource, int day) const {
+        auto found = days.find(key(resource, day));
+        return found == days.end() ? nullptr : &found->second;
+    }
+
+    // the first and last day anything is booked on (any chair); false if nothing is
+    bool dayRange(int& first, int& last) const {
+        if (days.empty()) return false;
+        first = std::numeric_limits<int>::max();
+        last = std::numeric_limits<int>::min();
+        for (const auto& entry : days) {
+            int day = static_cast<int>(static_cast<std::uint32_t>(entry.first));
+            first = std::min(first, day);
+            last = std::max(last, day);
+        }
+        return true;
+    }
+
+    // earliest start on the grid from + k*interval where [start, start+duration) fits before closeTime
+    // returns -1 if nothing fits
+    int findFreeSlot(int resource, int day, int from, int closeTime, int duration, int interval) const {
+        int candidate = from;
+        auto found = days.find(key(resource, day));
+        if (found != days.end()) {
+            for (const auto& b : found->second) {
+                if (b.end <= candidate) continue;             // already behind us
+                if (candidate + duration <= b.start) break;   // fits in the gap before this booking
+                candidate = from + ((b.end - from + interval - 1) / interval) * interval; // jump past it, snapped to the grid
+                if (candidate + duration > closeTime) return -1;
+            }
+        }
+        return (candidate + duration <= closeTime) ? candidate : -1;
+    }
+
+private:
+    static std::uint64_t key(int resource, int day) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(resource)) << 32) | static_cast<std::uint32_t>(day);
+    }
+    
+    void place(const Appointment& apt, size_t slot, int resource) {
+        BookedInterval interval{apt.start, apt.start + apt.duration, slot};
+        auto& day = days[key(resource, apt.day)];
+        if (day.empty() || day.back().start <= apt.start) { // stores are written in order, so this is the usual case
+            day.push_back(interval);
+            return;
+        }
+        auto pos = std::upper_bound(day.begin(), day.end(), apt.start,
+            [](int value, const BookedInterval& b) { return value < b.start; });
+        day.insert(pos, interval);
+    }
+    
+    std::vector<std::string> resources; // id -> name ("" for id 0 until a first chair is named)
+    std::unordered_map<std::uint64_t, std::vector<BookedInterval>> days; // (resource, day) -> intervals sorted by start
+};
+
+// Case-insensitive index from client name to the slots of that client's live appointments.
+// Names are interned: each distinct client gets an id the first time it is seen, keyed by a view of that
+// first spelling (appointment text lives in a TextArena, so the view stays valid). Lookups hash the
+// query in place, so they never allocate. The clients with live appointments are also kept in a prefix
+// trie, updated as they come and go, for completing names
+class ClientIndex {
+public:
+    void insert(std::string_view name, size_t slot) {
+        auto found = ids.find(name);
+        if (found == ids.end()) {
+            found = ids.emplace(name, static_cast<std::uint32_t>(slotsOf.size())).first;
+            slotsOf.emplace_back();
+        }
+        auto& slots = slotsOf[found->second];
+        if (slots.empty()) names.insert(found->first);
+        slots.push_back(slot);
+    }
+    
+    // forget one slot of a client (swap with the last, order within a client isn't kept)
+    void erase(std::string_view name, size_t slot) {
+        auto found = ids.find(name);
+        if (found == ids.end()) return;
+        auto& slots = slotsOf[found->second];
+        auto it = std::find(slots.begin(), slots.end(), slot);
+        if (it != slots.end()) {
+            *it = slots.back();
+            slots.pop_back();
+            if (slots.empty()) names.erase(found->first);
+        }
+    }
+    
+    // slots of every live appointment for name (any capitalization), or nullptr for an unknown client
+    const std::vector<size_t>* find(std::string_view name) const {
+        auto found = ids.find(name);
+        return found == ids.end() ? nullptr : &slotsOf[found->second];
+    }
+    
+    // clients (as first spelled) whose name starts with prefix, any capitalization
+    PrefixMatches complete(std::string_view prefix, size_t limit) const { return names.complete(prefix, limit, true); }
+    
+    // whether two spellings are the same client
+    static bool sameName(std::string_view a, std::string_view b) { return FoldedEqual()(a, b); }
+    
+private:
+    static char fold(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+    
+    struct FoldedHash {
+        size_t operator()(std::string_view name) const {
+            std::uint64_t hash = 14695981039346656037ull; // FNV-1a over the lowercased bytes
+            for (char c : name) {
+                hash ^= static_cast<unsigned char>(fold(c));
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+    struct FoldedEqual {
+        bool operator()(std::string_view a, std::string_view b) const {
+            if (a.size() != b.size()) return false;
+            for (size_t i = 0; i < a.size(); ++i) {
+                if (fold(a[i]) != fold(b[i])) return false;
+            }
+            return true;
+        }
+    };
+    
+    std::unordered_map<std::string_view, std::uint32_t, FoldedHash, FoldedEqual> ids; // name -> client id
+    std::vector<std::vector<size_t>> slotsOf; // client id -> slots
+    PrefixTrie names; // clients with at least one live slot
+};
+
+// Appointments for a run of consecutive days, grouped by day and sorted by start time.
+// Built in one pass over the index's day buckets into two pre-sized arrays (offsets + slots),
+// so rendering a week or month never scans the whole history or copies an Appointment
+struct DayBuckets {
+    int firstDay = 0;
+    std::vector<size_t> offsets; // day d's slots are slots[offsets[d]] .. slots[offsets[d + 1] - 1]
+    std::vector<size_t> slots;   // positions in the appointments vector
+    
+    size_t countOn(int d) const { return offsets[d + 1] - offsets[d]; }
+    size_t total() const { return slots.size(); }
+};
+
+DayBuckets bucketDays(const ScheduleIndex& index, int firstDay, int dayCount);
+
+// Display name of a resource
+std::string resourceLabel(const ScheduleIndex& index, int resource);
+
+// A standing appointment: the same client, time, service and chair every `weeks` weeks on the weekday of its
+// first date, until lastDay. Only the rule is stored; occurrences are expanded for the days a view or a slot
+// search asks about, so memory grows with the number of rules, not with how far ahead anyone looks
+struct RecurrenceRule {
+    static constexpr int openEnded = std::numeric_limits<int>::max();
+    
+    Appointment pattern;        // every occurrence is this with the date changed; date/day are the first occurrence
+    int weeks = 1;              // weeks between occurrences
+    int lastDay = openEnded;    // no occurrence after this day
+    std::vector<int> cancelled; // days of single occurrences that were cancelled or moved, sorted
+    
+    // call visit(day) for every occurrence in first..last that wasn't cancelled
+    template <typename Visit>
+    void forEachOccurrence(int first, int last, Visit visit) const {
+        int period = weeks * 7;
+        last = std::min(last, lastDay);
+        int day = pattern.day;
+        if (first > day) day += (first - day + period - 1) / period * period; // first occurrence on or after first
+        for (; day <= last; day += period) {
+            if (!std::binary_search(cancelled.begin(), cancelled.end(), day)) visit(day);
+        }
+    }
+    
+    bool occursOn(int day) const {
+        return day >= pattern.day && day <= lastDay && (day - pattern.day) % (weeks * 7) == 0 &&
+               !std::binary_search(cancelled.begin(), cancelled.end(), day);
+    }
+    
+    // first occurrence on or after from, or openEnded once the rule has run out
+    int nextOccurrence(int from) const {
+        int period = weeks * 7;
+        int day = pattern.day;
+        if (from > day) day += (from - day + period - 1) / period * period;
+        for (; day <= lastDay; day += period) {
+            if (!std::binary_search(cancelled.begin(), cancelled.end(), day)) return day;
+        }
+        return openEnded;
+    }
+    
+    // drop or bring back a single occurrence
+    void cancel(int day) {
+        auto pos = std::lower_bound(cancelled.begin(), cancelled.end(), day);
+        if (pos == cancelled.end() || *pos != day) cancelled.insert(pos, day);
+    }
+    void restore(int day) {
+        auto pos = std::lower_bound(cancelled.begin(), cancelled.end(), day);
+        if (pos != cancelled.end() && *pos == day) cancelled.erase(pos);
+    }
+    
+    // "every 2 weeks on Tuesday"
+    std::string describe() const {
+        std::string text = weeks == 1 ? "every week" : "every " + std::to_string(weeks) + " weeks";
+        return text + " on " + std::string(dayOfWeekName(pattern.day));
+    }
+};
+
+// The schedule of days first..last as views and slot searches see it: the stored appointments plus the
+// occurrences of recurring rules, expanded for just those days. When no rule has an occurrence in the window
+// it is the stored schedule itself and nothing is copied; otherwise the window's appointments are copied
+// into a small index of its own, so building one never changes the session (reads stay read-only)
+class ScheduleWindow {
+public:
+    ScheduleWindow(const std::vector<Appointment>& stored, const ScheduleIndex& storedIndex,
+                   const std::vector<RecurrenceRule>& rules, int first, int last)
+        : stored(&stored), storedIndex(&storedIndex) {
+        std::vector<std::pair<int, const RecurrenceRule*>> due; // (day, rule) of every occurrence in the window
+        for (const auto& rule : rules) {
+            rule.forEachOccurrence(first, last, [&](int day) { due.push_back({day, &rule}); });
+        }
+        if (due.empty()) return;
+        
+        expanded = true;
+        int resources = storedIndex.resourceCount();
+        for (int r = 0; r < resources; ++r) ownIndex.addResource(storedIndex.resourceName(r)); // same chair ids
+        for (int day = first; day <= last; ++day) {
+            for (int r = 0; r < resources; ++r) {
+                if (const auto* bookings = storedIndex.bookingsOn(r, day)) {
+                    for (const auto& b : *bookings) {
+                        ownIndex.insert(stored[b.slot], own.size());
+                        own.push_back(stored[b.slot]);
+                    }
+                }
+            }
+        }
+        dates.resize(static_cast<size_t>(last - first) + 1); // sized once, so views of the strings stay put
+        for (const auto& occurrence : due) {
+            std::string& date = dates[occurrence.first - first];
+            if (date.empty()) date = daysToDate(occurrence.first);
+            Appointment apt = occurrence.second->pattern;
+            apt.date = date;
+            apt.day = occurrence.first;
+            ownIndex.insert(apt, own.size());
+            own.push_back(apt);
+        }
+    }
+    
+    // movable but not copyable: the expanded appointments point into dates
+    ScheduleWindow(ScheduleWindow&&) = default;
+    ScheduleWindow& operator=(ScheduleWindow&&) = default;
+    
+    const std::vector<Appointment>& appointments() const { return expanded ? own : *stored; }
+    const ScheduleIndex& index() const { return expanded ? ownIndex : *storedIndex; }
+    
+private:
+    const std::vector<Appointment>* stored;
+    const ScheduleIndex* storedIndex;
+    bool expanded = false;
+    std::vector<Appointment> own;
+    ScheduleIndex ownIndex;
+    std::vector<std::string> dates; // text of the occurrence dates, one per day of the window
+};
+
+// Find next available time slot (with optional admin override) within the configured hours of the date
+// (see config.h), skipping breaks, on any of the shop's chairs, or only on
+// onlyResource if it is >= 0. The chair that gets it is stored in *resource; the earliest time wins and
+// ties go to the lower-numbered chair
+std::string findNextAvailableTime(const ScheduleIndex& index, std::string_view date, int duration,
+                                  bool adminOverride = false, int* resource = nullptr, int onlyResource = -1);
+
+// How findBestSlots orders the free slots it finds. Whatever the order, ties go to the earlier slot and
+// then to the lower-numbered chair
+struct SlotRanking {
+    enum class Order {
+        earliest,  // soonest first
+        fit,       // least fragmentation: slots that close a gap exactly, then those that leave the smallest hole
+        preferred  // slots inside [preferredStart, preferredEnd) first, then the closest to it
+    };
+    Order order = Order::earliest;
+    int preferredStart = 0; // minutes since midnight
+    int preferredEnd = 0;
+
+    // "earliest", "fit" or a range of hours like "2pm-5pm"; false if text is none of them
+    bool parse(std::string_view text);
+    std::string describe() const;
+};
+
+// What to look for: count free slots of duration on days firstDay .. firstDay + days - 1
+struct SlotSearch {
+    int firstDay = 0;
+    int days = 14;
+    int duration = 30;
+    size_t count = 3;
+    size_t perDay = 1;          // at most this many from any one day (spreads the choices out); 0 for no limit
+    bool adminOverride = false; // search until the override closing time (10pm by default)
+    int onlyResource = -1;      // only this chair, if >= 0
+    SlotRanking ranking;
+};
+
+// One free slot findBestSlots turned up
+struct SlotCandidate {
+    int day;
+    int start;    // minutes since midnight
+    int resource;
+    int penalty;  // how badly it ranks under the search's ranking (0 is ideal)
+    
+    // ranks ahead of other: the lower penalty, then the earlier slot, then the lower chair
+    bool before(const SlotCandidate& other) const {
+        if (penalty != other.penalty) return penalty < other.penalty;
+        if (day != other.day) return day < other.day;
+        if (start != other.start) return start < other.start;
+        return resource < other.resource;
+    }
+};
+
+// The search.count best free slots, best first. Each day is one pass over its bookings per chair, so the cost is
+// O(bookings in the range + candidate slots); with the earliest order the scan stops as soon as it has enough
+std::vector<SlotCandidate> findBestSlots(const ScheduleIndex& index, const SlotSearch& search);
+
+// Add an appointment to the list, reusing a slot freed by removeAppointment if there is one, and index it.
+// Returns its slot
+size_t addAppointment(std::vector<Appointment>& appointments, ScheduleIndex& index, const Appointment& apt,
+                      std::vector<size_t>& freeSlots);
+
+// Remove the appointment at the given position from the index and leave its slot in the list as a tombstone
+// for the next add. Nothing else moves, so slot numbers held by the indexes stay valid
+void removeAppointment(std::vector<Appointment>& appointments, ScheduleIndex& index, size_t slot,
+                       std::vector<size_t>& freeSlots);
+
+// Report the first existing appointment on apt's chair overlapping apt, or nullptr if it fits
+const Appointment* findConflict(const std::vector<Appointment>& appointments, const ScheduleIndex& index, const Appointment& apt);
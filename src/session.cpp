@@ -0,0 +1,1846 @@
+#include "session.h"
+
+#include "config.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+// every command by name, for parsing and completion alike
+static const PrefixTrie& commandNames() {
+    static const PrefixTrie names = [] {
+        const std::pair<const char*, cmdType> commands[] = {
+            {"exit", cmdType::exit}, {"add", cmdType::add}, {"del", cmdType::del}, {"reschedule", cmdType::reschedule},
+            {"display", cmdType::display}, {"client", cmdType::client}, {"repeat", cmdType::repeat},
+            {"stats", cmdType::stats}, {"slots", cmdType::slots}, {"report", cmdType::report}, {"wait", cmdType::wait}, {"begin", cmdType::begin},
+            {"commit", cmdType::commit}, {"rollback", cmdType::rollback}, {"undo", cmdType::undo}, {"redo", cmdType::redo}, {"help", cmdType::help}};
+        PrefixTrie trie;
+        for (const auto& command : commands) trie.insert(command.first, static_cast<int>(command.second));
+        return trie;
+    }();
+    return names;
+}
+
+cmdType getCommandCode(const std::string& input) {
+    int code = commandNames().find(input);
+    if (code < 0) throw std::invalid_argument("Unknown command");
+    return static_cast<cmdType>(code);
+}
+
+void displayHelp(std::ostream& out) {
+    out << "\n=====  MirrorBooking Commands  =====\n" << '\n';
+    
+    out << "add <name> <time> <service> [date]" << '\n';
+    out << " Add a new appointment" << '\n';
+    out << " time: specific time (e.g., 10am, 2:30pm) or 'next' for next available slot" << '\n';
+    out << " service: " << shopConfig().services.describe() << ", or custom minutes assigned via number" << '\n';
+    out << " date: optional, defaults to today (format: YYYY-MM-DD)" << '\n';
+    out << " Examples:" << '\n';
+    out << "   add Henry 10am hair (add appointment with customer 'Henry', 30 min hair appoint, today)" << '\n';
+    out << "   add John next beard (add appointment with customer 'John', 15 min beard appoint, next available slot today)" << '\n';
+    out << "   add Jane 2pm full 2025-12-15 (add appointment with customer 'Jane', 45 min full service, on 2025-12-15)" << '\n';
+    out << '\n';
+    
+    out << "del <name> <time> [date]" << '\n';
+    out << " Delete an appointment - NOTE: both <name> and <time> are required, use display to find exact time and name" << '\n';
+    out << " For a recurring appointment this cancels one occurrence (the next one, or the one on date)" << '\n';
+    out << " Example: del Henry 10am (delete appointment for Henry at 10am today)" << '\n';
+    out << '\n';
+    
+    out << "reschedule <name> <oldTime> <newTime> [newDate]" << '\n';
+    out << " Reschedule an existing appointment" << '\n';
+    out << " newTime: specific time or 'next' for next available slot" << '\n';
+    out << " Examples:" << '\n';
+    out << "   reschedule Henry 10am 2pm (reschedule appointment for Henry from 10am to 2pm today)" << '\n';
+    out << "   reschedule John 10am next (reschedule appointment for John from 10am to next available slot today)" << '\n';
+    out << "   reschedule Jane 2pm 3pm 2025-12-15 (reschedule appointment for Jane from 2pm to 3pm on 2025-12-15) " << '\n';
+    out << '\n';
+    
+    out << "display [view]" << '\n';
+    out << " Display schedule in different views" << '\n';
+    out << " view options:" << '\n';
+    out << "   daily (default) - Show today's detailed schedule" << '\n';
+    out << "   weekly - Show current week overview" << '\n';
+    out << "   weekly next - Show next week" << '\n';
+    out << "   weekly prev - Show previous week" << '\n';
+    out << "   monthly [next|prev] - Show a month as a calendar with appointment counts" << '\n';
+    out << "   YYYY-MM-DD - Show specific date" << '\n';
+    out << " Examples:" << '\n';
+    out << "   display (display today's detailed schedule)" << '\n';
+    out << "   display weekly (display current week's overview)" << '\n';
+    out << "   display 2025-12-15 (display schedule for specific date)" << '\n';
+    out << '\n';
+    
+    out << "client <name>" << '\n';
+    out << " List every appointment of a client, past and upcoming (name is not case sensitive)" << '\n';
+    out << " Example: client henry" << '\n';
+    out << '\n';
+    
+    out << "repeat <name> <time> <service> <weeks> [first] [last]" << '\n';
+    out << " Book a client every <weeks> weeks on the weekday of the first date, at the same time" << '\n';
+    out << " first: a date or a weekday (mon..sun, the next one), defaults to today; last: optional end date" << '\n';
+    out << " repeat list - Show all recurring appointments" << '\n';
+    out << " repeat end <name> <time> [lastDate] - Stop a recurring appointment (from today, or after lastDate)" << '\n';
+    out << " Examples:" << '\n';
+    out << "   repeat Henry 10am hair 2 tue (Henry every second Tuesday at 10am, starting next Tuesday)" << '\n';
+    out << "   repeat Jane 2pm full 4 2025-12-15 2026-06-30 (Jane every 4 weeks on Mondays until the end of June)" << '\n';
+    out << '\n';
+    
+    out << "slots <service> [date] [earliest|fit|<from>-<to>] [@chair]" << '\n';
+    out << " Show the 5 best free slots for a service over the two weeks from date (default: today), one per day" << '\n';
+    out << " Ranked by the earliest, the best fit (fewest leftover gaps) or the closest to a range of hours" << '\n';
+    out << " When add or reschedule with 'next' finds the day full, they offer the 3 best slots of the days after it" << '\n';
+    out << " Examples:" << '\n';
+    out << "   slots full (next free 45-minute slots from today)" << '\n';
+    out << "   slots hair 2025-12-15 5pm-6pm (30-minute slots closest to 5-6pm from 2025-12-15 on)" << '\n';
+    out << '\n';
+    
+    out << "report [week|month|year|all|<from> [to]]" << '\n';
+    out << " How full the chairs were (per day, week or month, per chair, weekday and hour), the service mix, revenue" << '\n';
+    out << " for services with a price in the config, and how many bookings sit back to back. Default: this month" << '\n';
+    out << " from/to: dates (YYYY-MM-DD); to defaults to today. 'all' covers every day with a booking" << '\n';
+    out << " Examples:" << '\n';
+    out << "   report year (this calendar year so far and the rest of it)" << '\n';
+    out << "   report 2025-01-01 2025-03-31 (the first quarter of 2025)" << '\n';
+    out << '\n';
+    
+    out << "wait <name> <service> [first] [last] [<from>-<to>] [priority] [@chair]" << '\n';
+    out << " Put a client on the waitlist: when del or reschedule frees a slot that fits their service, day and hours," << '\n';
+    out << " they are booked into it right away (the highest priority first, then whoever joined first)" << '\n';
+    out << " first/last: dates (YYYY-MM-DD); one date waits for that day only, none for the next two weeks" << '\n';
+    out << " from-to: hours it may take place in (e.g., 10am-2pm); priority: a number, higher goes first (default 0)" << '\n';
+    out << " wait list - Show who is waiting" << '\n';
+    out << " wait drop <name> - Take a client off the waitlist" << '\n';
+    out << " Examples:" << '\n';
+    out << "   wait Henry hair (Henry takes any 30-minute cancellation in the next two weeks)" << '\n';
+    out << "   wait Jane full 2025-12-15 2025-12-19 4pm-7pm 2 (Jane, after 4pm that week, ahead of priority 0 and 1)" << '\n';
+    out << '\n';
+    
+    out << "undo / redo" << '\n';
+    out << " Take back the last change (one command, or a whole transaction) / apply it again" << '\n';
+    out << " The last 100 changes of the session can be undone" << '\n';
+    out << '\n';
+    
+    out << "begin / commit / rollback" << '\n';
+    out << " Group several commands into one transaction: after begin, changes show up right away but are only" << '\n';
+    out << " saved by commit, all together; rollback (or exit) takes them all back. A command that fails changes nothing" << '\n';
+    out << " Example: begin, del Henry 10am, add Henry 2pm hair, commit" << '\n';
+    out << '\n';
+    
+    out << "stats [reset]" << '\n';
+    out << " Show how many times each command ran and how long it took (p50/p95/p99), store load/save and journal" << '\n';
+    out << " sync times, bytes written and the size of the store files; 'reset' starts counting again" << '\n';
+    out << '\n';
+    
+    out << "help" << '\n';
+    out << "  Show this help message" << '\n';
+    out << '\n';
+    
+    out << "exit" << '\n';
+    out << "  Save and exit the program" << '\n';
+    out << '\n';
+}
+
+bool Session::open(const std::string& file, const LoadWindow& window, const std::vector<std::string>& chairs) {
+    filename = file;
+    loadWindow = window;
+    chairNames = chairs;
+    for (const auto& chair : chairs) index.addResource(chair);
+    size_t journalRecords = 0;
+    ScopedTimer timer(stats().startup);
+    try {
+        journalRecords = recoverAppointments(appointments, index, pager, filename, arena, window, false, &seen);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+    if (!journal.open(filename + ".journal", journalRecords)) {
+        std::cerr << "Error: Could not open journal; changes will not be saved." << std::endl;
+    }
+    rules = loadRules(filename + ".rules", arena);
+    {
+        auto lock = lockStore();
+        loadWaitlist(true);
+    }
+    watcher.open(filename);
+    watcher.changed(); // just loaded
+    catchUp(); // whatever was written since recovery read the store (the rules were read after it)
+    for (const auto& service : shopConfig().services.list()) serviceNames.insert(service.name);
+    return true;
+}
+
+CommandResult Session::execute(const std::string& input, CommandIO& io) {
+    //holds parsed command and arguments
+    std::string command;
+    std::string args;
+
+    size_t spacePos = input.find(' '); // find first space to separate command and follow up arguments
+    if (spacePos != std::string::npos) {
+        command = input.substr(0, spacePos);
+        args = input.substr(spacePos + 1);
+    } else {
+        command = input;
+        args = "";
+    }
+
+    if (!io.shared) { // the daemon catches up when the watcher wakes it, between its clients' commands
+        bool hadHistory = history.undoable() + history.redoable() > 0;
+        if (refresh() && hadHistory) io.out << "(Another MirrorBooking changed the store; undo history cleared.)" << std::endl;
+    }
+    
+    ScopedTimer timer(stats().command(command));
+    size_t mark = pending.size(); // the steps this command adds start here
+    CommandResult result = CommandResult::failed;
+    try { 
+        switch(cmdType type = getCommandCode(command)){
+            case cmdType::exit:
+                if (size_t dropped = discardTransaction()) {
+                    io.out << "Rolled back the open transaction (" << dropped << " change(s))." << std::endl;
+                }
+                result = CommandResult::exit;
+                break;
+            case cmdType::add: result = addCommand(args, io); break;
+            case cmdType::del: result = delCommand(args, io); break;
+            case cmdType::reschedule: result = rescheduleCommand(args, io); break;
+            case cmdType::help:
+                displayHelp(io.view.frame.stream());
+                showFrame(io);
+                result = CommandResult::ok;
+                break;
+            case cmdType::display: result = displayCommand(args, io); break;
+            case cmdType::client: result = clientCommand(args, io); break;
+            case cmdType::repeat: result = repeatCommand(args, io); break;
+            case cmdType::stats: result = statsCommand(args, io); break;
+            case cmdType::slots: result = slotsCommand(args, io); break;
+            case cmdType::report: result = reportCommand(args, io); break;
+            case cmdType::wait: result = waitCommand(args, io); break;
+            case cmdType::begin:
+            case cmdType::commit:
+            case cmdType::rollback: result = transactionCommand(type, io); break;
+            case cmdType::undo: result = undoCommand(false, io); break;
+            case cmdType::redo: result = undoCommand(true, io); break;
+        }
+    } catch (const std::invalid_argument& e) {
+        io.err << "Error: " << e.what() << std::endl; // handle unknown command
+        result = CommandResult::failed;
+    }
+    
+    if (result == CommandResult::failed) {
+        rollbackTo(mark); // a command that fails leaves the schedule as it found it
+    } else if (pending.size() > mark) {
+        if (inTransaction) {
+            transactionLabel += (transactionLabel.empty() ? "" : "; ") + input;
+        } else if (!commitPending(input, io)) {
+            result = CommandResult::failed;
+        }
+    }
+    return result;
+}
+
+void Session::commit() {
+    journal.commit();
+    if (journal.size() < Compactor::threshold) return; // most commits: not worth taking the lock
+    auto lock = lockStore();
+    if (othersWrote()) return; // rotating would take records this process hasn't read yet out of its sight
+    compactor.maybeStart(filename, journal);
+    seen = StoreVersion::of(filename);
+}
+
+bool Session::refresh() {
+    if (inTransaction || batchLock || !stale()) return false;
+    return catchUp();
+}
+
+bool Session::stale() {
+    if (!watcher.changed()) return false;
+    auto lock = lockStore(StoreLock::Mode::shared);
+    return StoreVersion::of(filename) != seen;
+}
+
+void Session::beginBatch() {
+    // up to date first: nothing is checked against the others once the batch has the store to itself
+    while (true) {
+        batchLock = std::make_unique<StoreLock>(filename);
+        if (!othersWrote()) break;
+        batchLock.reset(); // catching up may load the store again, which takes the lock itself
+        catchUp();
+    }
+    journal.reopenIfMoved();
+    journal.hold();
+}
+
+Completion Session::complete(const std::string& line, size_t cursor) {
+    constexpr size_t shown = 40; // choices listed at most
+    Completion completion;
+    std::string_view before = std::string_view(line).substr(0, std::min(cursor, line.size()));
+    size_t space = before.find_last_of(' ');
+    completion.start = space == std::string_view::npos ? 0 : space + 1;
+    std::string_view word = before.substr(completion.start);
+    std::vector<std::string> words; // the ones before it, chairs left out
+    std::istringstream iss(std::string(before.substr(0, completion.start)));
+    for (std::string each; iss >> each;) {
+        if (each[0] != '@') words.push_back(each);
+    }
+    
+    std::vector<PrefixMatches> found;
+    auto keywords = [&](std::initializer_list<std::string_view> list) {
+        PrefixTrie trie;
+        for (auto keyword : list) trie.insert(keyword);
+        found.push_back(trie.complete(word, shown));
+    };
+    auto clientNames = [&]() {
+        indexNewClients();
+        found.push_back(clients.complete(word, shown));
+        PrefixTrie recurring; // clients with only a recurring appointment or a waitlist entry aren't in the index
+        for (const auto& rule : rules) recurring.insert(rule.pattern.name);
+        waitlist.forEach([&](const WaitlistEntry& entry) { recurring.insert(entry.request.name); });
+        found.push_back(recurring.complete(word, shown, true));
+    };
+    std::string_view command = words.empty() ? std::string_view() : std::string_view(words[0]);
+    size_t position = words.size();
+    if (!word.empty() && word[0] == '@') {
+        PrefixTrie chairs;
+        for (int r = 0; r < index.resourceCount(); ++r) chairs.insert("@" + std::string(index.resourceName(r)));
+        found.push_back(chairs.complete(word, shown, true));
+    } else if (position == 0) {
+        found.push_back(commandNames().complete(word, shown));
+    } else if (command == "add" || command == "reschedule") {
+        if (position == 1) clientNames();
+        if (position == (command == "add" ? 2 : 3)) keywords({"next"});
+        if (command == "add" && position == 3) found.push_back(serviceNames.complete(word, shown));
+    } else if (command == "del" || command == "client") {
+        if (position == 1) clientNames();
+    } else if (command == "repeat") {
+        if (position == 1) {
+            keywords({"list", "end"});
+            clientNames();
+        } else if (words[1] == "end") {
+            if (position == 2) clientNames();
+        } else if (position == 3 && words[1] != "list") {
+            found.push_back(serviceNames.complete(word, shown));
+        }
+    } else if (command == "wait") {
+        if (position == 1) {
+            keywords({"list", "drop"});
+            clientNames();
+        } else if (words[1] == "drop") {
+            if (position == 2) clientNames();
+        } else if (position == 2 && words[1] != "list") {
+            found.push_back(serviceNames.complete(word, shown));
+        }
+    } else if (command == "slots") {
+        if (position == 1) found.push_back(serviceNames.complete(word, shown));
+        if (position >= 2) keywords({"earliest", "fit"});
+    } else if (command == "display") {
+        if (position == 1) keywords({"daily", "weekly", "monthly"});
+        if (position == 2 && words[1] != "daily") keywords({"next", "prev"});
+    } else if (command == "stats") {
+        if (position == 1) keywords({"reset"});
+    } else if (command == "report") {
+        if (position == 1) keywords({"week", "month", "year", "all"});
+    }
+    
+    // the sources together: every choice once, in order, and what they all have in common
+    std::string common;
+    bool any = false;
+    for (auto& matches : found) {
+        if (matches.total == 0) continue;
+        completion.total += matches.total;
+        if (!any) {
+            common = matches.common;
+            any = true;
+        } else {
+            size_t same = 0;
+            while (same < common.size() && same < matches.common.size() && common[same] == matches.common[same]) ++same;
+            common.resize(same);
+        }
+        for (auto& option : matches.words) completion.options.push_back(std::move(option));
+    }
+    std::sort(completion.options.begin(), completion.options.end());
+    size_t listed = completion.options.size();
+    completion.options.erase(std::unique(completion.options.begin(), completion.options.end()), completion.options.end());
+    completion.total -= listed - completion.options.size(); // the same client found twice
+    if (completion.options.size() > shown) completion.options.resize(shown);
+    completion.text = common.size() >= word.size() ? common : std::string(word);
+    return completion;
+}
+
+bool Session::readsOnly(const std::string& input) {
+    std::string command = input.substr(0, input.find(' '));
+    return command == "display" || command == "client" || command == "help" || command == "slots" ||
+           command == "report" || input == "stats" || input == "wait" || input == "wait list"; // not "stats reset"
+}
+
+void Session::loadAll() {
+    pager.loadAll(appointments, index, arena);
+    indexNewClients();
+}
+
+void Session::close() {
+    if (size_t dropped = discardTransaction()) {
+        std::cerr << "Warning: rolled back a transaction that was never committed (" << dropped << " change(s))" << std::endl;
+    }
+    journal.commit();
+    batchLock.reset(); // only once its records are all written, so nobody appends in the middle of one
+    compactor.wait();
+    {
+        auto lock = lockStore();
+        journal.reopenIfMoved(); // another process rotated it: its fold takes care of this one's records
+        compactor.maybeStart(filename, journal, true);
+    }
+    compactor.wait();
+    auto lock = lockStore();
+    // everything is in the snapshot now, don't leave an empty journal behind (unless another process filled it)
+    if (journal.size() == 0 && StoreVersion::of(filename).journalBytes == 0) {
+        journal.close();
+        std::error_code ec;
+        std::filesystem::remove(filename + ".journal", ec);
+    }
+    // and the waitlist file down to the clients still waiting, if others haven't added to it meanwhile
+    if (waitlistRecords > waitlist.size() && StoreVersion::of(filename).sameWaitlist(seen)) compactWaitlist();
+}
+
+void Session::ensureDate(std::string_view date) {
+    int day = dateToDays(date);
+    pager.ensureLoaded(day, day, appointments, index, arena);
+}
+
+ScheduleWindow Session::window(int first, int last) const {
+    return ScheduleWindow(appointments, index, rules, first, last);
+}
+
+void Session::loadWaitlist(bool truncateTorn) {
+    StoreVersion now = StoreVersion::of(filename);
+    std::vector<WaitlistRecord> records;
+    size_t read = readWaitlist(filename + ".waitlist", 0, arena, records, truncateTorn);
+    waitlist.assign({});
+    for (const auto& record : records) waitlist.apply(record);
+    waitlist.prune(getCurrentDay()); // gone from the file the next time it is rewritten
+    waitlistRecords = records.size();
+    seen.waitlistInode = now.waitlistInode;
+    seen.waitlistBytes = read;
+}
+
+void Session::catchUpWaitlist(const StoreVersion& now) {
+    if (now.waitlistInode != seen.waitlistInode || now.waitlistBytes < seen.waitlistBytes || now.waitlistInode == 0) {
+        loadWaitlist(); // rewritten (or removed) since: what it held before can't be told apart any more
+        return;
+    }
+    std::vector<WaitlistRecord> records;
+    seen.waitlistBytes = readWaitlist(filename + ".waitlist", seen.waitlistBytes, arena, records);
+    for (const auto& record : records) waitlist.apply(record);
+    waitlistRecords += records.size();
+}
+
+bool Session::compactWaitlist() {
+    waitlist.prune(getCurrentDay());
+    if (!::saveWaitlist(waitlist.entries(), filename + ".waitlist")) return false;
+    waitlistRecords = waitlist.size();
+    return true;
+}
+
+void Session::indexNewClients() {
+    for (; clientsIndexed < appointments.size(); ++clientsIndexed) {
+        clients.insert(appointments[clientsIndexed].name, clientsIndexed);
+    }
+}
+
+size_t Session::book(const Appointment& apt) {
+    Step step;
+    step.op = Step::Op::book;
+    step.apt = apt;
+    step.slot = applyBook(apt);
+    pending.push_back(std::move(step));
+    return pending.back().slot;
+}
+
+void Session::unbook(size_t slot) {
+    Step step;
+    step.op = Step::Op::unbook;
+    step.apt = appointments[slot];
+    step.slot = slot;
+    applyUnbook(slot);
+    pending.push_back(std::move(step));
+}
+
+void Session::changeRule(size_t rule, std::optional<RecurrenceRule> after) {
+    Step step;
+    step.op = Step::Op::rule;
+    step.rule = rule;
+    if (rule < rules.size()) step.before = rules[rule];
+    step.after = std::move(after);
+    applyRule(rule, step.before, step.after);
+    pending.push_back(std::move(step));
+}
+
+void Session::changeWaitlist(std::optional<WaitlistEntry> before, std::optional<WaitlistEntry> after) {
+    Step step;
+    step.op = Step::Op::wait;
+    step.waitingBefore = std::move(before);
+    step.waitingAfter = std::move(after);
+    applyWaitlist(step.waitingBefore, step.waitingAfter);
+    pending.push_back(std::move(step));
+}
+
+size_t Session::applyBook(const Appointment& apt, size_t slot) {
+    indexNewClients();
+    // an undone delete goes back into its own slot, so the store keeps its order
+    auto freed = std::find(freeSlots.rbegin(), freeSlots.rend(), slot);
+    if (freed != freeSlots.rend()) std::iter_swap(freed, freeSlots.rbegin());
+    slot = addAppointment(appointments, index, apt, freeSlots);
+    clients.insert(apt.name, slot);
+    if (slot == clientsIndexed) ++clientsIndexed; // appended, already indexed
+    return slot;
+}
+
+void Session::applyUnbook(size_t slot) {
+    indexNewClients();
+    clients.erase(appointments[slot].name, slot);
+    removeAppointment(appointments, index, slot, freeSlots);
+}
+
+void Session::applyRule(size_t rule, const std::optional<RecurrenceRule>& from, const std::optional<RecurrenceRule>& to) {
+    auto at = rules.begin() + static_cast<std::ptrdiff_t>(rule);
+    if (!from) {
+        rules.insert(at, *to);
+    } else if (!to) {
+        rules.erase(at);
+    } else {
+        *at = *to;
+    }
+}
+
+void Session::applyWaitlist(const std::optional<WaitlistEntry>& from, std::optional<WaitlistEntry>& to) {
+    if (from) waitlist.remove(from->joined);
+    if (to) to->joined = waitlist.add(*to).joined; // a new entry gets its place in line, for undo to find it by
+}
+
+void Session::replay(Step& step, bool forward) {
+    switch (step.op) {
+        case Step::Op::wait:
+            applyWaitlist(forward ? step.waitingBefore : step.waitingAfter, forward ? step.waitingAfter : step.waitingBefore);
+            return;
+        case Step::Op::rule:
+            applyRule(step.rule, forward ? step.before : step.after, forward ? step.after : step.before);
+            return;
+        case Step::Op::book:
+        case Step::Op::unbook:
+            if ((step.op == Step::Op::book) == forward) {
+                step.slot = applyBook(step.apt, step.slot);
+            } else {
+                applyUnbook(step.slot);
+            }
+            return;
+    }
+}
+
+void Session::journalSteps(const std::vector<Step>& steps, bool forward) {
+    journal.hold(); // however many records, they are synced together by the next commit()
+    auto log = [&](const Step& step) {
+        if (step.op == Step::Op::book || step.op == Step::Op::unbook) journal.append((step.op == Step::Op::book) == forward ? '+' : '-', step.apt);
+    };
+    if (forward) {
+        std::for_each(steps.begin(), steps.end(), log);
+    } else {
+        std::for_each(steps.rbegin(), steps.rend(), log);
+    }
+}
+
+bool Session::journalWaitlist(const std::vector<Step>& steps, bool forward) {
+    std::vector<WaitlistRecord> records;
+    auto log = [&](const Step& step) {
+        if (step.op != Step::Op::wait) return;
+        const auto& leaving = forward ? step.waitingBefore : step.waitingAfter;
+        const auto& joining = forward ? step.waitingAfter : step.waitingBefore;
+        if (leaving) records.push_back(WaitlistRecord{'-', *leaving});
+        if (joining) records.push_back(WaitlistRecord{'+', *joining});
+    };
+    if (forward) {
+        std::for_each(steps.begin(), steps.end(), log);
+    } else {
+        std::for_each(steps.rbegin(), steps.rend(), log);
+    }
+    if (waitlistRecords + records.size() > 2 * waitlist.size() + waitlistSlack) {
+        return compactWaitlist(); // the steps are applied already, so it holds them
+    }
+    if (!appendWaitlist(records, filename + ".waitlist")) return false;
+    waitlistRecords += records.size();
+    return true;
+}
+
+void Session::rollbackTo(size_t mark) {
+    while (pending.size() > mark) {
+        replay(pending.back(), false);
+        pending.pop_back();
+    }
+}
+
+bool Session::commitPending(const std::string& label, CommandIO& io) {
+    if (!writeSteps(pending, true, io)) {
+        rollbackTo(0);
+        catchUp();
+        return false;
+    }
+    history.record(Transaction{label, std::move(pending)});
+    pending.clear();
+    return true;
+}
+
+bool Session::writeSteps(const std::vector<Step>& steps, bool forward, CommandIO& io) {
+    bool rulesChanged = std::any_of(steps.begin(), steps.end(), [](const Step& step) { return step.op == Step::Op::rule; });
+    bool waitlistChanged = std::any_of(steps.begin(), steps.end(), [](const Step& step) { return step.op == Step::Op::wait; });
+    auto lock = lockStore();
+    if (!batchLock && othersWrote()) {
+        io.err << "Error: Another MirrorBooking changed the store in the meantime; nothing was saved. "
+               << "The schedule is up to date now, try again." << std::endl;
+        return false;
+    }
+    if ((rulesChanged && !saveRules()) || (waitlistChanged && !journalWaitlist(steps, forward))) {
+        io.err << "Error: Nothing was changed." << std::endl;
+        return false;
+    }
+    if (batchLock) { // the batch has the store to itself until close()
+        journalSteps(steps, forward);
+        return true;
+    }
+    journal.reopenIfMoved();
+    journalSteps(steps, forward);
+    journal.flush(); // readable by the others as soon as the lock is released
+    seen = StoreVersion::of(filename);
+    return true;
+}
+
+bool Session::othersWrote() {
+    StoreVersion now = StoreVersion::of(filename);
+    if (now == seen) return false;
+    if (!now.sameRules(seen) || !now.sameWaitlist(seen)) return true;
+    StoreVersion moved = seen;
+    TextArena scratch;
+    std::vector<JournalRecord> records;
+    if (!readJournalSince(filename, moved, scratch, records) || !records.empty()) return true;
+    seen = moved;
+    return false;
+}
+
+bool Session::catchUp() {
+    auto lock = lockStore(StoreLock::Mode::shared);
+    StoreVersion now = StoreVersion::of(filename);
+    if (now == seen) return false;
+    std::vector<JournalRecord> records;
+    if (!readJournalSince(filename, seen, arena, records)) {
+        reload();
+        return true;
+    }
+    for (const auto& record : records) applyRecord(record);
+    bool rulesChanged = !now.sameRules(seen);
+    if (rulesChanged) rules = loadRules(filename + ".rules", arena);
+    seen.rulesInode = now.rulesInode;
+    seen.rulesModified = now.rulesModified;
+    bool waitlistChanged = !now.sameWaitlist(seen);
+    if (waitlistChanged) catchUpWaitlist(now);
+    if (records.empty() && !rulesChanged && !waitlistChanged) return false; // only compacted
+    history.clear();
+    return true;
+}
+
+void Session::applyRecord(const JournalRecord& record) {
+    const Appointment& apt = record.apt;
+    if (!pager.hasDay(apt.day)) {
+        pager.defer(record); // applied with the rest of the journal when the day is paged in
+        return;
+    }
+    size_t same = ScheduleIndex::noSlot;
+    int resource = index.findResource(apt.resource);
+    if (const auto* day = resource < 0 ? nullptr : index.bookingsOn(resource, apt.day)) {
+        for (const auto& b : *day) {
+            if (sameBooking(appointments[b.slot], apt)) {
+                same = b.slot;
+                break;
+            }
+        }
+    }
+    if (record.op == '+' && same == ScheduleIndex::noSlot) {
+        applyBook(apt);
+    } else if (record.op == '-' && same != ScheduleIndex::noSlot) {
+        applyUnbook(same);
+    }
+}
+
+void Session::reload() {
+    // into a text arena of its own, swapped in for the old one: a daemon reloads over and over
+    TextArena loadedText;
+    std::vector<Appointment> loaded;
+    ScheduleIndex loadedIndex;
+    DayPager loadedPager;
+    StoreVersion loadedAt;
+    for (const auto& chair : chairNames) loadedIndex.addResource(chair);
+    try {
+        recoverAppointments(loaded, loadedIndex, loadedPager, filename, loadedText, loadWindow, true, &loadedAt);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Could not load " << filename << " again: " << e.what() << std::endl;
+        return;
+    }
+    bool everything = pager.complete(); // the daemon keeps every day in memory
+    history.clear(); // its steps point into the old text
+    appointments = std::move(loaded);
+    index = std::move(loadedIndex);
+    pager = std::move(loadedPager);
+    clients = ClientIndex();
+    clientsIndexed = 0;
+    freeSlots.clear();
+    rules.clear();
+    arena = std::move(loadedText); // nothing points into the old text any more
+    if (everything) loadAll();
+    rules = loadRules(filename + ".rules", arena);
+    seen = loadedAt;
+    loadWaitlist();
+}
+
+size_t Session::discardTransaction() {
+    if (!inTransaction) return 0;
+    size_t dropped = pending.size();
+    rollbackTo(0);
+    inTransaction = false;
+    transactionLabel.clear();
+    return dropped;
+}
+
+const std::vector<size_t>* Session::clientSlots(std::string_view name) {
+    pager.loadAll(appointments, index, arena);
+    indexNewClients();
+    return clients.find(name);
+}
+
+size_t Session::findAppointment(const std::string& name, int start, int onDay) {
+    indexNewClients();
+    auto search = [&]() {
+        size_t best = ScheduleIndex::noSlot;
+        if (const auto* slots = clients.find(name)) {
+            int today = getCurrentDay();
+            for (size_t slot : *slots) {
+                const Appointment& apt = appointments[slot];
+                if (apt.start != start || (onDay != anyDay && apt.day != onDay)) continue;
+                if (best == ScheduleIndex::noSlot) {
+                    best = slot;
+                    continue;
+                }
+                int bestDay = appointments[best].day;
+                bool upcoming = apt.day >= today, bestUpcoming = bestDay >= today;
+                if (upcoming != bestUpcoming ? upcoming : (upcoming ? apt.day < bestDay : apt.day > bestDay)) best = slot;
+            }
+        }
+        return best;
+    };
+    size_t slot = search();
+    if (slot == ScheduleIndex::noSlot && onDay == anyDay && !pager.complete()) { // a given day is paged in by the caller
+        pager.loadAll(appointments, index, arena);
+        indexNewClients();
+        slot = search();
+    }
+    return slot;
+}
+
+Session::Target Session::findTarget(const std::string& name, int start, int onDay) {
+    Target target;
+    target.slot = findAppointment(name, start, onDay);
+    if (rules.empty() || (onDay != anyDay && target.slot != ScheduleIndex::noSlot)) return target;
+    
+    int today = getCurrentDay();
+    int next = RecurrenceRule::openEnded;
+    size_t rule = noRule;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const RecurrenceRule& candidate = rules[i];
+        if (candidate.pattern.start != start || !ClientIndex::sameName(candidate.pattern.name, name)) continue;
+        int day = onDay != anyDay ? (candidate.occursOn(onDay) ? onDay : RecurrenceRule::openEnded)
+                                  : candidate.nextOccurrence(today);
+        if (day < next) {
+            next = day;
+            rule = i;
+        }
+    }
+    if (rule == noRule) return target;
+    if (target.slot != ScheduleIndex::noSlot) {
+        int stored = appointments[target.slot].day;
+        if (stored >= today && stored <= next) return target;
+    }
+    target.slot = ScheduleIndex::noSlot;
+    target.rule = rule;
+    target.day = next;
+    return target;
+}
+
+std::vector<size_t> Session::clientRules(std::string_view name) const {
+    std::vector<size_t> found;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        if (ClientIndex::sameName(rules[i].pattern.name, name)) found.push_back(i);
+    }
+    return found;
+}
+
+bool Session::takeResource(std::string& args, int& resource, CommandIO& io) const {
+    size_t at = args.find('@');
+    if (at == std::string::npos || (at > 0 && args[at - 1] != ' ')) return true;
+    size_t end = args.find(' ', at);
+    std::string name = args.substr(at + 1, end == std::string::npos ? std::string::npos : end - at - 1);
+    args.erase(at, end == std::string::npos ? std::string::npos : end - at + 1);
+    resource = index.findResource(name);
+    if (name.empty() || resource < 0) {
+        io.err << "Error: Unknown chair '" << name << "'. Chairs:";
+        for (int r = 0; r < index.resourceCount(); ++r) io.err << " " << resourceLabel(index, r);
+        io.err << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Session::fitsStore(const Appointment& apt, CommandIO& io) const {
+    if (!isBinaryStore(filename)) return true;
+    std::string overflow = binaryOverflow(apt);
+    if (overflow.empty()) return true;
+    io.err << "Error: " << overflow << "." << std::endl;
+    return false;
+}
+
+int Session::freeResource(const ScheduleWindow& schedule, const Appointment& apt, int requested, int preferred) const {
+    auto isFree = [&](int r) { return !schedule.index().findOverlap(r, apt.day, apt.start, apt.start + apt.duration); };
+    if (requested >= 0) return isFree(requested) ? requested : -1;
+    if (isFree(preferred)) return preferred;
+    for (int r = 0; r < index.resourceCount(); ++r) {
+        if (r != preferred && isFree(r)) return r;
+    }
+    return -1;
+}
+
+const Appointment* Session::conflictOn(const ScheduleWindow& schedule, const Appointment& apt, int resource) {
+    const BookedInterval* hit = schedule.index().findOverlap(resource, apt.day, apt.start, apt.start + apt.duration);
+    return hit ? &schedule.appointments()[hit->slot] : nullptr;
+}
+
+std::string Session::onChair(int resource) const {
+    return index.resourceCount() > 1 && resource >= 0 ? " on " + resourceLabel(index, resource) : "";
+}
+
+std::vector<SlotCandidate> Session::bestSlots(const SlotSearch& search) {
+    int last = search.firstDay + search.days - 1;
+    pager.ensureLoaded(search.firstDay, last, appointments, index, arena);
+    return findBestSlots(window(search.firstDay, last).index(), search);
+}
+
+bool Session::chooseAlternative(Appointment& apt, int chair, int& resource, const char* cancelled, CommandIO& io) {
+    int day = dateToDays(apt.date);
+    SlotSearch search;
+    search.firstDay = day + 1;
+    search.duration = apt.duration;
+    search.onlyResource = chair;
+    search.ranking = slotRanking;
+    std::vector<SlotCandidate> slots = bestSlots(search); // every choice at once, not one more day at a time
+    
+    io.out << "No available slots for " << apt.date << ". Options:" << std::endl;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        io.out << "  " << i + 1 << ". " << dayOfWeekName(slots[i].day) << " " << daysToDate(slots[i].day)
+               << " at " << minutesToTime(slots[i].start) << onChair(slots[i].resource) << std::endl;
+    }
+    if (slots.empty()) io.out << "  (nothing free in the " << search.days << " days after it)" << std::endl;
+    size_t overrideChoice = slots.size() + 1;
+    io.out << "  " << overrideChoice << ". Admin override (book after hours on " << apt.date << ")" << std::endl;
+    io.out << "  " << overrideChoice + 1 << ". Cancel" << std::endl;
+    io.out << "Choose (1-" << overrideChoice + 1 << "): ";
+    
+    std::string choice;
+    if (io.prompt) std::getline(*io.prompt, choice); // nobody to ask in batch mode: cancel
+    size_t picked = 0;
+    std::from_chars(choice.data(), choice.data() + choice.size(), picked);
+    
+    if (picked >= 1 && picked <= slots.size()) {
+        const SlotCandidate& slot = slots[picked - 1];
+        apt.date = arena.intern(daysToDate(slot.day));
+        apt.time = arena.intern(minutesToTime(slot.start));
+        resource = slot.resource;
+        return true;
+    }
+    if (picked == overrideChoice) {
+        ScheduleWindow schedule = window(day, day);
+        apt.time = arena.intern(findNextAvailableTime(schedule.index(), apt.date, apt.duration, true, &resource, chair));
+        if (apt.time.empty()) {
+            io.err << "Error: No available time slots even with override." << std::endl;
+            return false;
+        }
+        io.out << "[Admin Override] Booking after hours." << std::endl;
+        return true;
+    }
+    io.out << cancelled << std::endl;
+    return false;
+}
+
+void Session::showFrame(CommandIO& io) {
+    if (&io.out == &std::cout) {
+        ::showFrame(io.view.frame);
+    } else {
+        io.out << io.view.frame.str();
+        io.view.frame.clear();
+    }
+}
+
+void Session::backfill(const Appointment& freed, int resource, CommandIO& io) {
+    if (waitlist.empty() || resource < 0) return;
+    int day = freed.day;
+    int today = getCurrentDay();
+    if (day < today) return; // nobody is waiting for the past
+    int from = freed.start, to = freed.start + freed.duration;
+    int earliest = day == today ? getCurrentTimeInMinutes() : 0;
+    
+    // the free stretches of the chair's open hours that overlap what was freed (an after-hours booking frees only
+    // its own time), with the recurring occurrences counted as booked
+    std::vector<std::pair<int, int>> open;
+    for (const auto& run : shopConfig().hoursOn(day).runs) {
+        if (run.first < to && run.second > from) open.push_back(run);
+    }
+    if (open.empty()) open.push_back({from, to});
+    ScheduleWindow schedule = window(day, day);
+    const auto* bookings = schedule.index().bookingsOn(resource, day);
+    std::vector<std::pair<int, int>> stretches;
+    for (const auto& run : open) {
+        int cursor = std::max(run.first, earliest);
+        if (bookings) {
+            for (const auto& b : *bookings) {
+                if (b.end <= cursor) continue;
+                if (b.start >= run.second) break;
+                if (b.start > cursor) stretches.push_back({cursor, b.start});
+                cursor = b.end;
+            }
+        }
+        if (cursor < run.second) stretches.push_back({cursor, run.second});
+    }
+    for (const auto& stretch : stretches) {
+        if (stretch.first < to && stretch.second > from) {
+            fillGap(resource, day, stretch.first, stretch.second, std::max(from, stretch.first), std::min(to, stretch.second), io);
+        }
+    }
+}
+
+void Session::fillGap(int resource, int day, int start, int end, int from, int to, CommandIO& io) {
+    if (from >= to || waitlist.empty()) return;
+    size_t found = waitlist.match(day, start, end, from, to, index.resourceName(resource));
+    if (found == Waitlist::none) return;
+    Appointment apt = waitlist[found].request;
+    int at = waitlist[found].startIn(start, end, from); // as near the freed time as its hours allow: over it, match made sure
+    apt.date = arena.intern(daysToDate(day));
+    apt.time = arena.intern(minutesToTime(at));
+    apt.resource = arena.intern(index.resourceName(resource));
+    normalizeAppointment(apt);
+    if (!fitsStore(apt, io)) return; // the entry fitted; the chair it got may not
+    changeWaitlist(waitlist[found], std::nullopt);
+    book(apt);
+    io.out << "Booked from the waitlist: " << apt.name << " at " << apt.time << " on " << apt.date << " ("
+           << apt.service << ", " << apt.duration << " min)" << onChair(resource) << std::endl;
+    // what is left of the freed time on either side
+    fillGap(resource, day, start, at, from, std::min(to, at), io);
+    fillGap(resource, day, at + apt.duration, end, std::max(from, at + apt.duration), to, io);
+}
+
+CommandResult Session::addCommand(std::string args, CommandIO& io) {
+    //  args order: "name time service [date]", plus "@chair" anywhere to pick the chair
+    // Examples: "Henry 10am hair", "John next beard", "Jane 2pm full 2025-12-01", "Al 3pm hair @Mike"
+    int chair = -1;
+    if (!takeResource(args, chair, io)) return CommandResult::failed;
+    std::istringstream iss(args);
+    Appointment apt;
+    std::string nameInput, timeInput, serviceInput, dateInput;
+    
+    if (!(iss >> nameInput >> timeInput >> serviceInput)) { // Mandatory fields
+        io.err << "Error: Invalid format. Use: add <name> <time> <service> <date>" << std::endl;
+        io.err << "  time: time (ex: 10am) or 'next' for next available" << std::endl;
+        io.err << "  service: hair/beard/full or minutes (ex: 30)" << std::endl;
+        io.err << "  date: optional (YYYY-MM-DD), defaults to today" << std::endl;
+        return CommandResult::failed;
+    }
+    
+    // parse service and duration
+    apt.duration = parseServiceDuration(serviceInput);
+    if (apt.duration <= 0) {
+        io.err << "Error: Invalid service. Use " << shopConfig().services.describe() << ", or a number of minutes." << std::endl;
+        return CommandResult::failed;
+    }
+    apt.name = arena.intern(nameInput);
+    apt.service = arena.intern(serviceInput);
+    
+    // parse date (optional, default:today)
+    if (iss >> dateInput) {
+        apt.date = arena.intern(dateInput);
+    } else {
+        apt.date = arena.intern(getCurrentDate());
+    }
+    ensureDate(apt.date);
+    ScheduleWindow schedule = window(dateToDays(apt.date), dateToDays(apt.date)); // recurring occurrences count as booked
+    
+    // handle 'next' time slot for quick booking of soonest available, on whichever chair frees up first
+    int resource = -1;
+    if (timeInput == "next") {
+        apt.time = arena.intern(findNextAvailableTime(schedule.index(), apt.date, apt.duration, false, &resource, chair));
+        
+        // if the day is full, offer the best slots of the days after it, or admin override
+        if (apt.time.empty() && !chooseAlternative(apt, chair, resource, "Booking cancelled.", io)) {
+            return CommandResult::failed;
+        }
+    } else { // specific time provided
+        apt.time = arena.intern(timeInput);
+    }
+    
+    normalizeAppointment(apt);
+    
+    // check for overlaps, return error if true
+    if (resource < 0) resource = freeResource(schedule, apt, chair, 0);
+    if (resource < 0) {
+        const Appointment* existing = conflictOn(schedule, apt, chair >= 0 ? chair : 0);
+        io.err << "Error: Appointment overlaps with existing appointment for " 
+               << existing->name << " at " << existing->time << std::endl;
+        return CommandResult::failed;
+    }
+    apt.resource = arena.intern(index.resourceName(resource));
+    if (!fitsStore(apt, io)) return CommandResult::failed;
+    // if no overlaps, add appointment
+    book(apt);
+    io.out << "Added appointment: " << apt.name << " at " << apt.time 
+           << " on " << apt.date << " (" << apt.service << ", " 
+           << apt.duration << " min)" << onChair(resource) << std::endl;
+    return CommandResult::ok;
+}
+
+CommandResult Session::delCommand(const std::string& args, CommandIO& io) {
+    // takes: "name time [date]" (e.g., "Henry 10am", "Henry 10am 2025-12-15")
+    std::istringstream iss(args);
+    std::string name, time, date;
+    
+    if (!(iss >> name >> time)) {
+        io.err << "Error: Invalid format. Use: del <name> <time> [date] (Use display command to find your appointment details)" << std::endl;
+        return CommandResult::failed;
+    }
+    int day = anyDay;
+    if (iss >> date) {
+        ensureDate(date);
+        day = dateToDays(date);
+    }
+    
+    // find and delete the appointment
+    Target target = findTarget(name, timeToMinutes(time), day);
+    if (!target.found()) {
+        io.err << "Error: No appointment found for " << name << " at " << time << (date.empty() ? "" : " on " + date) << std::endl;
+        return CommandResult::failed;
+    }
+    if (target.rule != noRule) { // one occurrence of a recurring appointment: cancel just that one
+        RecurrenceRule cancelled = rules[target.rule];
+        cancelled.cancel(target.day);
+        changeRule(target.rule, std::move(cancelled));
+        const RecurrenceRule& rule = rules[target.rule];
+        io.out << "Cancelled appointment: " << rule.pattern.name << " at " << rule.pattern.time
+               << " on " << daysToDate(target.day) << " (" << rule.pattern.service << ", "
+               << rule.pattern.duration << " min); still booked " << rule.describe() << std::endl;
+        Appointment freed = rule.pattern;
+        freed.day = target.day;
+        backfill(freed, index.findResource(freed.resource), io);
+        return CommandResult::ok;
+    }
+    size_t slot = target.slot;
+    Appointment apt = appointments[slot];
+    io.out << "Deleted appointment: " << apt.name << " at " << apt.time 
+           << " on " <<  apt.date << " (" << apt.service << ", " 
+           << apt.duration << " min)" << std::endl;
+    unbook(slot); // remove from list
+    backfill(apt, index.findResource(apt.resource), io);
+    return CommandResult::ok;
+}
+
+CommandResult Session::rescheduleCommand(std::string args, CommandIO& io) {
+    // uses: "name oldTime newTime [newDate]", plus "@chair" anywhere to move it to another chair
+    // examples: "Henry 10am 2pm", "John 10am next", "Jane 2pm 3pm 2025-12-05", "Al 3pm 3pm @Mike"
+    int chair = -1;
+    if (!takeResource(args, chair, io)) return CommandResult::failed;
+    std::istringstream iss(args);
+    std::string name, oldTime, newTimeInput, newDateInput;
+    
+    if (!(iss >> name >> oldTime >> newTimeInput)) {
+        io.err << "Error: Invalid format. Use: reschedule <name> <oldTime> <newTime> [newDate]" << std::endl;
+        io.err << "  Examples: reschedule Henry 10am 2pm, (where 10am appointment is rescheduled to 2pm)" << std::endl;
+        io.err << "            reschedule John 10am next (where 10am is rescheduled to the next available slot)" << std::endl;
+        return CommandResult::failed;
+    }
+    
+    // find the existing appointment
+    Target target = findTarget(name, timeToMinutes(oldTime));
+    
+    if (!target.found()) {
+        io.err << "Error: No appointment found for " << name << " at " << oldTime << std::endl;
+        return CommandResult::failed;
+    }
+    
+    // store original appointment details in temp variables
+    // moving one occurrence of a recurring appointment cancels it in the rule and books the new time on its own
+    size_t slot = target.slot;
+    Appointment original;
+    if (target.rule != noRule) {
+        original = rules[target.rule].pattern;
+        original.date = arena.intern(daysToDate(target.day));
+        original.day = target.day;
+    } else {
+        original = appointments[slot];
+    }
+    Appointment rescheduled = original;
+    int originalResource = index.findResource(original.resource);
+    int resource = -1;
+    // take the original off the schedule while the new time is checked (a failed command puts it back)
+    auto release = [&]() {
+        if (target.rule != noRule) {
+            RecurrenceRule cancelled = rules[target.rule];
+            cancelled.cancel(target.day);
+            changeRule(target.rule, std::move(cancelled));
+        } else {
+            unbook(slot);
+        }
+    };
+    
+    if (iss >> newDateInput) {
+        rescheduled.date = arena.intern(newDateInput);
+    }
+    normalizeAppointment(rescheduled); // validate the new date before touching the schedule
+    ensureDate(rescheduled.date);
+    
+    // if 'next' is specified, find next available slot
+    if (newTimeInput == "next") {
+        release();
+        ScheduleWindow schedule = window(rescheduled.day, rescheduled.day);
+        
+        rescheduled.time = arena.intern(findNextAvailableTime(schedule.index(), rescheduled.date, rescheduled.duration, false, &resource, chair));
+        
+        // no slots available that day, offer the best ones after it
+        if (rescheduled.time.empty() && !chooseAlternative(rescheduled, chair, resource, "Reschedule cancelled.", io)) {
+            return CommandResult::failed;
+        }
+        
+        // add back the rescheduled appointment
+        normalizeAppointment(rescheduled);
+        rescheduled.resource = arena.intern(index.resourceName(resource));
+        if (!fitsStore(rescheduled, io)) return CommandResult::failed;
+        book(rescheduled);
+    } else {
+        rescheduled.time = arena.intern(newTimeInput); //new specific time
+        normalizeAppointment(rescheduled); // parse the new time before touching the schedule
+        release(); // remove original to check for overlaps
+        ScheduleWindow schedule = window(rescheduled.day, rescheduled.day);
+        
+        // check for overlaps with new time, on the same chair if it is free
+        resource = freeResource(schedule, rescheduled, chair, originalResource);
+        if (resource < 0) {
+            const Appointment* existing = conflictOn(schedule, rescheduled, chair >= 0 ? chair : originalResource);
+            io.err << "Error: New time overlaps with existing appointment for " 
+                   << existing->name << " at " << existing->time << std::endl;
+            return CommandResult::failed;
+        }
+        
+        rescheduled.resource = arena.intern(index.resourceName(resource));
+        if (!fitsStore(rescheduled, io)) return CommandResult::failed;
+        book(rescheduled);// add rescheduled appointment
+    }
+    
+    // a moved occurrence stays cancelled in its rule; the new time is a normal appointment
+    io.out << "Rescheduled appointment: " << original.name << " from " 
+           << original.time << " (" << original.date << ") to " 
+           << rescheduled.time << " (" << rescheduled.date << ")" << onChair(resource) << std::endl;
+    backfill(original, originalResource, io); // whatever of the old time the new one doesn't cover
+    return CommandResult::ok;
+}
+
+CommandResult Session::displayCommand(const std::string& args, CommandIO& io) {
+    // parse args: optional "daily", "weekly", "weekly next", "weekly prev", "monthly [next|prev]", or date
+    std::istringstream iss(args);
+    std::string viewType, navigation;
+    iss >> viewType;
+    iss >> navigation; // Optional second argument
+    Frame& frame = io.view.frame;
+    if (viewType.empty() || viewType == "daily") {
+        // display today's schedule by default
+        ensureDate(getCurrentDate());
+        ScheduleWindow schedule = window(getCurrentDay(), getCurrentDay());
+        displayDailySchedule(frame, schedule.appointments(), schedule.index(), getCurrentDate());
+    } else if (viewType == "weekly" || viewType == "week") {
+        // Handle weekly navigation
+        if (navigation == "next") {
+            io.view.weekStart = addDaysToDate(io.view.weekStart, 7);
+        } else if (navigation == "prev" || navigation == "previous") {
+            io.view.weekStart = addDaysToDate(io.view.weekStart, -7);
+        } else if (navigation.empty()) {
+            // Reset to current week if no navigation specified
+            io.view.weekStart = getWeekStart();
+        }
+        
+        int weekStart = dateToDays(io.view.weekStart);
+        pager.ensureLoaded(weekStart, weekStart + 6, appointments, index, arena);
+        ScheduleWindow schedule = window(weekStart, weekStart + 6);
+        displayWeeklySchedule(frame, schedule.appointments(), schedule.index(), io.view.weekStart);
+    } else if (viewType == "monthly" || viewType == "month") {
+        // Handle monthly navigation, same as weekly
+        if (navigation == "next") {
+            ++io.view.month;
+        } else if (navigation == "prev" || navigation == "previous") {
+            --io.view.month;
+        } else if (navigation.empty()) {
+            io.view.month = currentMonthNumber();
+        }
+        
+        int monthStart = daysFromCivil(io.view.month / 12, io.view.month % 12 + 1, 1);
+        CivilDate first = civilFromDays(monthStart);
+        int monthEnd = (first.month == 12 ? daysFromCivil(first.year + 1, 1, 1) : daysFromCivil(first.year, first.month + 1, 1)) - 1;
+        pager.ensureLoaded(monthStart, monthEnd, appointments, index, arena);
+        displayMonthlySchedule(frame, window(monthStart, monthEnd).index(), monthStart);
+    } else if (viewType.find("-") != std::string::npos) {
+        // specific date in YYYY-MM-DD format
+        ensureDate(viewType);
+        ScheduleWindow schedule = window(dateToDays(viewType), dateToDays(viewType));
+        displayDailySchedule(frame, schedule.appointments(), schedule.index(), viewType);
+    } else {
+        io.err << "Error: Invalid display option. Use 'daily', 'weekly [next|prev]', 'monthly [next|prev]', or a date (YYYY-MM-DD)" << std::endl;
+        return CommandResult::failed;
+    }
+    showFrame(io);
+    return CommandResult::ok;
+}
+
+CommandResult Session::clientCommand(const std::string& args, CommandIO& io) {
+    std::istringstream iss(args);
+    std::string name;
+    if (!(iss >> name)) {
+        io.err << "Error: Invalid format. Use: client <name>" << std::endl;
+        return CommandResult::failed;
+    }
+    
+    const std::vector<size_t>* found = clientSlots(name);
+    std::vector<size_t> recurring = clientRules(name);
+    if ((!found || found->empty()) && recurring.empty()) {
+        io.err << "Error: No appointments found for " << name << std::endl;
+        return CommandResult::failed;
+    }
+    std::vector<size_t> slots = found ? *found : std::vector<size_t>(); // sorted copy, the index keeps its own order
+    std::sort(slots.begin(), slots.end(), [this](size_t a, size_t b) {
+        const Appointment& x = appointments[a];
+        const Appointment& y = appointments[b];
+        return x.day != y.day ? x.day < y.day : x.start < y.start;
+    });
+    
+    Frame& frame = io.view.frame;
+    std::ostream& out = frame.stream();
+    int today = getCurrentDay();
+    size_t upcoming = 0;
+    out << "\n===== Appointments for " << (slots.empty() ? rules[recurring.front()].pattern.name : appointments[slots.front()].name)
+        << " =====\n" << '\n';
+    for (size_t slot : slots) {
+        const Appointment& apt = appointments[slot];
+        if (apt.day >= today) ++upcoming;
+        out << (apt.day < today ? frame.dim() : "") << dayOfWeekName(apt.day).substr(0, 3) << " " << apt.date << "  "
+            << std::left << std::setw(8) << apt.time << frame.paint(apt.kind) << apt.service << frame.plain()
+            << " (" << apt.duration << " min)" << onChair(index.findResource(apt.resource)) << frame.plain() << '\n';
+    }
+    for (size_t r : recurring) {
+        const RecurrenceRule& rule = rules[r];
+        int next = rule.nextOccurrence(today);
+        out << (next == RecurrenceRule::openEnded ? frame.dim() : "") << "Repeats " << rule.describe() << " at " << rule.pattern.time << ", "
+            << frame.paint(rule.pattern.kind) << rule.pattern.service << frame.plain() << " (" << rule.pattern.duration << " min)"
+            << onChair(index.findResource(rule.pattern.resource)) << ", next "
+            << (next == RecurrenceRule::openEnded ? std::string("none") : daysToDate(next)) << frame.plain() << '\n';
+    }
+    out << "\n" << slots.size() << " appointment(s), " << upcoming << " upcoming";
+    if (!recurring.empty()) out << ", " << recurring.size() << " recurring";
+    out << "." << '\n';
+    showFrame(io);
+    return CommandResult::ok;
+}
+
+CommandResult Session::repeatCommand(std::string args, CommandIO& io) {
+    // args: "name time service weeks [first] [last]", plus "@chair" anywhere to pick the chair;
+    // first is a date or a weekday (the next one from today). Or "list", or "end name time [lastDate]"
+    // Examples: "Henry 10am hair 2 tue", "Jane 2pm full 4 2025-12-15 2026-06-30", "end Henry 10am"
+    std::istringstream iss(args);
+    std::string first;
+    iss >> first;
+    if (first.empty() || first == "list") return listRules(io);
+    if (first == "end") return endRule(iss, io);
+    
+    int chair = -1;
+    if (!takeResource(args, chair, io)) return CommandResult::failed;
+    iss.str(args);
+    iss.clear();
+    std::string nameInput, timeInput, serviceInput, weeksInput, firstInput, lastInput;
+    if (!(iss >> nameInput >> timeInput >> serviceInput >> weeksInput) || timeInput == "next") {
+        io.err << "Error: Invalid format. Use: repeat <name> <time> <service> <weeks> [first] [last]" << std::endl;
+        io.err << "  first: date (YYYY-MM-DD) or weekday (mon..sun), defaults to today; last: optional end date" << std::endl;
+        return CommandResult::failed;
+    }
+    iss >> firstInput >> lastInput;
+    
+    RecurrenceRule rule;
+    auto weeks = std::from_chars(weeksInput.data(), weeksInput.data() + weeksInput.size(), rule.weeks);
+    if (weeks.ec != std::errc() || weeks.ptr != weeksInput.data() + weeksInput.size() || rule.weeks < 1 || rule.weeks > 52) {
+        io.err << "Error: Invalid number of weeks '" << weeksInput << "' (1-52)." << std::endl;
+        return CommandResult::failed;
+    }
+    Appointment& pattern = rule.pattern;
+    pattern.duration = parseServiceDuration(serviceInput);
+    if (pattern.duration <= 0) {
+        io.err << "Error: Invalid service. Use " << shopConfig().services.describe() << ", or a number of minutes." << std::endl;
+        return CommandResult::failed;
+    }
+    int today = getCurrentDay();
+    int firstDay = today;
+    if (int weekday = parseWeekday(firstInput); weekday >= 0) {
+        firstDay = today + (weekday - weekdayFromDays(today) + 7) % 7;
+    } else if (!firstInput.empty()) {
+        firstDay = dateToDays(firstInput);
+    }
+    if (!lastInput.empty()) {
+        rule.lastDay = dateToDays(lastInput);
+        if (rule.lastDay < firstDay) {
+            io.err << "Error: The last date is before the first one." << std::endl;
+            return CommandResult::failed;
+        }
+    }
+    pattern.name = arena.intern(nameInput);
+    pattern.time = arena.intern(timeInput);
+    pattern.service = arena.intern(serviceInput);
+    pattern.date = arena.intern(daysToDate(firstDay));
+    normalizeAppointment(pattern);
+    
+    // the rule needs one chair that is free at every occurrence, checked over the next half year
+    int horizon = static_cast<int>(std::min<long long>(rule.lastDay, static_cast<long long>(firstDay) + ruleCheckDays - 1));
+    pager.ensureLoaded(firstDay, horizon, appointments, index, arena);
+    ScheduleWindow schedule = window(firstDay, horizon);
+    auto firstClash = [&](int r) {
+        int clash = -1;
+        rule.forEachOccurrence(firstDay, horizon, [&](int day) {
+            if (clash < 0 && schedule.index().findOverlap(r, day, pattern.start, pattern.start + pattern.duration)) clash = day;
+        });
+        return clash;
+    };
+    int resource = -1;
+    int clashDay = firstClash(chair >= 0 ? chair : 0);
+    if (clashDay < 0) {
+        resource = chair >= 0 ? chair : 0;
+    } else if (chair < 0) {
+        for (int r = 1; r < index.resourceCount() && resource < 0; ++r) {
+            if (firstClash(r) < 0) resource = r;
+        }
+    }
+    if (resource < 0) {
+        Appointment probe = pattern;
+        probe.day = clashDay;
+        const Appointment* existing = conflictOn(schedule, probe, chair >= 0 ? chair : 0);
+        io.err << "Error: On " << daysToDate(clashDay) << " it overlaps with existing appointment for "
+               << existing->name << " at " << existing->time << std::endl;
+        return CommandResult::failed;
+    }
+    pattern.resource = arena.intern(index.resourceName(resource));
+    if (!fitsStore(pattern, io)) return CommandResult::failed; // its occurrences are booked like any appointment
+    
+    changeRule(rules.size(), std::move(rule));
+    const RecurrenceRule& added = rules.back();
+    io.out << "Added recurring appointment: " << added.pattern.name << " at " << added.pattern.time << " " << added.describe()
+           << " from " << added.pattern.date;
+    if (added.lastDay != RecurrenceRule::openEnded) io.out << " until " << daysToDate(added.lastDay);
+    io.out << " (" << added.pattern.service << ", " << added.pattern.duration << " min)" << onChair(resource) << std::endl;
+    return CommandResult::ok;
+}
+
+CommandResult Session::endRule(std::istringstream& iss, CommandIO& io) {
+    std::string name, time, lastInput;
+    if (!(iss >> name >> time)) {
+        io.err << "Error: Invalid format. Use: repeat end <name> <time> [lastDate]" << std::endl;
+        return CommandResult::failed;
+    }
+    int start = timeToMinutes(time);
+    int today = getCurrentDay();
+    int lastDay = today - 1;
+    if (iss >> lastInput) lastDay = dateToDays(lastInput);
+    
+    size_t found = noRule; // the matching rule that is still running, else any match
+    for (size_t r : clientRules(name)) {
+        if (rules[r].pattern.start != start) continue;
+        if (found == noRule || rules[r].nextOccurrence(today) != RecurrenceRule::openEnded) found = r;
+    }
+    if (found == noRule) {
+        io.err << "Error: No recurring appointment found for " << name << " at " << time << std::endl;
+        return CommandResult::failed;
+    }
+    
+    RecurrenceRule rule = rules[found];
+    std::string label = std::string(rule.pattern.name) + " at " + std::string(rule.pattern.time) + " " + rule.describe();
+    bool dropped = lastDay < rule.pattern.day;
+    if (dropped) {
+        changeRule(found, std::nullopt);
+    } else {
+        rule.lastDay = std::min(rule.lastDay, lastDay);
+        rule.cancelled.erase(std::upper_bound(rule.cancelled.begin(), rule.cancelled.end(), rule.lastDay), rule.cancelled.end());
+        changeRule(found, std::move(rule));
+    }
+    if (dropped) {
+        io.out << "Removed recurring appointment: " << label << std::endl;
+    } else {
+        io.out << "Ended recurring appointment: " << label << ", last one on or before " << daysToDate(rules[found].lastDay) << std::endl;
+    }
+    return CommandResult::ok;
+}
+
+CommandResult Session::listRules(CommandIO& io) {
+    Frame& frame = io.view.frame;
+    std::ostream& out = frame.stream();
+    int today = getCurrentDay();
+    out << "\n===== Recurring appointments =====\n" << '\n';
+    if (rules.empty()) out << "[No recurring appointments]" << '\n';
+    for (const auto& rule : rules) {
+        int next = rule.nextOccurrence(today);
+        bool over = next == RecurrenceRule::openEnded;
+        out << (over ? frame.dim() : "") << std::left << std::setw(12) << rule.pattern.name << " " << std::setw(8) << rule.pattern.time
+            << frame.paint(rule.pattern.kind) << rule.pattern.service << frame.plain() << (over ? frame.dim() : "")
+            << " (" << rule.pattern.duration << " min) " << rule.describe() << onChair(index.findResource(rule.pattern.resource))
+            << ", from " << rule.pattern.date;
+        if (rule.lastDay != RecurrenceRule::openEnded) out << " until " << daysToDate(rule.lastDay);
+        if (!rule.cancelled.empty()) out << ", " << rule.cancelled.size() << " cancelled";
+        out << ", next " << (over ? std::string("none") : daysToDate(next)) << frame.plain() << '\n';
+    }
+    out << "\n" << rules.size() << " recurring appointment(s)." << '\n';
+    showFrame(io);
+    return CommandResult::ok;
+}
+
+CommandResult Session::waitCommand(std::string args, CommandIO& io) {
+    // args: "name service [first] [last] [<from>-<to>] [priority]", plus "@chair" anywhere to wait for one chair.
+    // Or "list", or "drop name"
+    // Examples: "Henry hair", "Jane full 2025-12-15 2025-12-19 4pm-7pm 2", "drop Henry"
+    std::istringstream iss(args);
+    std::string first;
+    iss >> first;
+    if (first.empty() || first == "list") return listWaitlist(io);
+    if (first == "drop") {
+        std::string name;
+        if (!(iss >> name)) {
+            io.err << "Error: Invalid format. Use: wait drop <name>" << std::endl;
+            return CommandResult::failed;
+        }
+        std::vector<WaitlistEntry> leaving;
+        waitlist.forEach([&](const WaitlistEntry& entry) {
+            if (ClientIndex::sameName(entry.request.name, name)) leaving.push_back(entry);
+        });
+        for (auto& entry : leaving) changeWaitlist(std::move(entry), std::nullopt);
+        size_t dropped = leaving.size();
+        if (dropped == 0) {
+            io.err << "Error: " << name << " is not on the waitlist." << std::endl;
+            return CommandResult::failed;
+        }
+        io.out << "Took " << name << " off the waitlist (" << dropped << " entr" << (dropped == 1 ? "y" : "ies") << ")." << std::endl;
+        return CommandResult::ok;
+    }
+    
+    int chair = -1;
+    if (!takeResource(args, chair, io)) return CommandResult::failed;
+    iss.str(args);
+    iss.clear();
+    std::string nameInput, serviceInput;
+    if (!(iss >> nameInput >> serviceInput)) {
+        io.err << "Error: Invalid format. Use: wait <name> <service> [first] [last] [<from>-<to>] [priority] [@chair]" << std::endl;
+        return CommandResult::failed;
+    }
+    WaitlistEntry entry;
+    Appointment& request = entry.request;
+    request.duration = parseServiceDuration(serviceInput);
+    if (request.duration <= 0) {
+        io.err << "Error: Invalid service. Use " << shopConfig().services.describe() << ", or a number of minutes." << std::endl;
+        return CommandResult::failed;
+    }
+    std::vector<int> dates;
+    int from = 0;
+    for (std::string word; iss >> word;) {
+        size_t dashes = static_cast<size_t>(std::count(word.begin(), word.end(), '-'));
+        if (dashes == 2 && dates.size() < 2) {
+            dates.push_back(dateToDays(word));
+        } else if (dashes == 1 && word.front() != '-' && word.back() != '-') {
+            size_t dash = word.find('-');
+            from = timeToMinutes(word.substr(0, dash));
+            entry.to = timeToMinutes(word.substr(dash + 1));
+        } else if (std::all_of(word.begin(), word.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            std::from_chars(word.data(), word.data() + word.size(), entry.priority);
+        } else {
+            io.err << "Error: Invalid '" << word << "'. Use dates (YYYY-MM-DD), hours like 10am-2pm or a priority number" << std::endl;
+            return CommandResult::failed;
+        }
+    }
+    int today = getCurrentDay();
+    int firstDay = dates.empty() ? today : dates[0];
+    entry.lastDay = dates.size() == 2 ? dates[1] : dates.empty() ? today + waitDays - 1 : firstDay;
+    if (entry.lastDay < firstDay) {
+        io.err << "Error: The last date is before the first one." << std::endl;
+        return CommandResult::failed;
+    }
+    if (entry.lastDay < today) {
+        io.err << "Error: Those days are over." << std::endl;
+        return CommandResult::failed;
+    }
+    if (entry.to - from < request.duration) {
+        io.err << "Error: A " << request.duration << "-minute appointment doesn't fit between "
+               << minutesToTime(from) << " and " << minutesToTime(entry.to) << "." << std::endl;
+        return CommandResult::failed;
+    }
+    request.name = arena.intern(nameInput);
+    request.service = arena.intern(serviceInput);
+    request.date = arena.intern(daysToDate(firstDay));
+    request.time = arena.intern(minutesToTime(from));
+    if (chair >= 0) request.resource = arena.intern(index.resourceName(chair));
+    normalizeAppointment(request);
+    if (!fitsStore(request, io)) return CommandResult::failed; // it is booked as it is when a slot frees up
+    
+    changeWaitlist(std::nullopt, std::move(entry));
+    const WaitlistEntry& added = *pending.back().waitingAfter;
+    io.out << "Added to the waitlist: " << added.request.name << " (" << added.request.service << ", "
+           << added.request.duration << " min) " << describeWait(added) << onChair(chair) << ", "
+           << waitlist.size() << " waiting" << std::endl;
+    return CommandResult::ok;
+}
+
+CommandResult Session::listWaitlist(CommandIO& io) {
+    Frame& frame = io.view.frame;
+    std::ostream& out = frame.stream();
+    int today = getCurrentDay();
+    out << "\n===== Waitlist =====\n" << '\n';
+    if (waitlist.empty()) out << "[Nobody is waiting]" << '\n';
+    // in the order they get a freed slot: priority, then who joined first
+    std::vector<const WaitlistEntry*> order;
+    order.reserve(waitlist.size());
+    waitlist.forEach([&](const WaitlistEntry& entry) { order.push_back(&entry); });
+    std::stable_sort(order.begin(), order.end(), [](const WaitlistEntry* a, const WaitlistEntry* b) { return a->priority > b->priority; });
+    for (const WaitlistEntry* waiting : order) {
+        const WaitlistEntry& entry = *waiting;
+        bool over = entry.lastDay < today;
+        out << (over ? frame.dim() : "") << std::left << std::setw(12) << entry.request.name << " "
+            << frame.paint(entry.request.kind) << entry.request.service << frame.plain() << (over ? frame.dim() : "")
+            << " (" << entry.request.duration << " min) " << describeWait(entry)
+            << onChair(index.findResource(entry.request.resource)) << ", priority " << entry.priority << frame.plain() << '\n';
+    }
+    out << "\n" << waitlist.size() << " client(s) waiting." << '\n';
+    showFrame(io);
+    return CommandResult::ok;
+}
+
+std::string Session::describeWait(const WaitlistEntry& entry) {
+    std::string text = entry.lastDay == entry.firstDay() ? "on " + std::string(entry.request.date)
+                                                         : "from " + std::string(entry.request.date) + " to " + daysToDate(entry.lastDay);
+    if (entry.from() > 0 || entry.to < minutesPerDay) {
+        text += ", " + minutesToTime(entry.from()) + "-" + (entry.to < minutesPerDay ? minutesToTime(entry.to) : std::string("close"));
+    }
+    return text;
+}
+
+bool Session::parseSlotSearch(std::string args, SlotSearch& search, CommandIO& io) const {
+    int chair = -1;
+    if (!takeResource(args, chair, io)) return false;
+    std::istringstream iss(args);
+    std::string serviceInput;
+    if (!(iss >> serviceInput)) {
+        io.err << "Error: Invalid format. Use: slots <service> [date] [earliest|fit|<from>-<to>] [@chair]" << std::endl;
+        return false;
+    }
+    search.duration = parseServiceDuration(serviceInput);
+    if (search.duration <= 0) {
+        io.err << "Error: Invalid service. Use " << shopConfig().services.describe() << ", or a number of minutes." << std::endl;
+        return false;
+    }
+    search.firstDay = getCurrentDay();
+    search.count = 5;
+    search.onlyResource = chair;
+    search.ranking = slotRanking;
+    for (std::string word; iss >> word;) {
+        if (std::count(word.begin(), word.end(), '-') == 2) {
+            search.firstDay = dateToDays(word);
+        } else if (!search.ranking.parse(word)) {
+            io.err << "Error: Invalid ranking '" << word << "'. Use 'earliest', 'fit' or a range of hours like 2pm-5pm" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<Appointment> Session::bookingsBetween(int first, int last, TextArena& text) {
+    pager.ensureLoaded(first, last, appointments, index, arena);
+    ScheduleWindow schedule = window(first, last);
+    std::vector<Appointment> found;
+    DayBuckets days = bucketDays(schedule.index(), first, last - first + 1);
+    for (size_t slot : days.slots) {
+        found.push_back(schedule.appointments()[slot]);
+        found.back().date = text.intern(found.back().date);
+    }
+    return found;
+}
+
+CommandResult Session::slotsCommand(std::string args, CommandIO& io) {
+    SlotSearch search;
+    if (!parseSlotSearch(std::move(args), search, io)) return CommandResult::failed;
+    
+    std::vector<SlotCandidate> slots = bestSlots(search);
+    std::ostream& out = io.view.frame.stream();
+    out << "\n===== Free " << search.duration << "-minute slots from " << daysToDate(search.firstDay)
+        << " (" << search.ranking.describe() << ") =====\n" << '\n';
+    if (slots.empty()) out << "[Nothing free in the next " << search.days << " days]" << '\n';
+    for (size_t i = 0; i < slots.size(); ++i) {
+        out << "  " << i + 1 << ". " << std::left << std::setw(10) << dayOfWeekName(slots[i].day) << daysToDate(slots[i].day)
+            << " at " << minutesToTime(slots[i].start) << onChair(slots[i].resource) << '\n';
+    }
+    showFrame(io);
+    return CommandResult::ok;
+}
+
+CommandResult Session::reportCommand(const std::string& args, CommandIO& io) {
+    std::istringstream iss(args);
+    std::string from, to, extra;
+    iss >> from >> to >> extra;
+    int today = getCurrentDay();
+    CivilDate now = civilFromDays(today);
+    int first = 0, last = 0;
+    if (from.empty() || from == "month") {
+        first = daysFromCivil(now.year, now.month, 1);
+        last = (now.month == 12 ? daysFromCivil(now.year + 1, 1, 1) : daysFromCivil(now.year, now.month + 1, 1)) - 1;
+    } else if (from == "week") {
+        first = weekStartFromDays(today);
+        last = first + 6;
+    } else if (from == "year") {
+        first = daysFromCivil(now.year, 1, 1);
+        last = daysFromCivil(now.year + 1, 1, 1) - 1;
+    } else if (from == "all") {
+        loadAll();
+        bool any = index.dayRange(first, last);
+        for (const auto& rule : rules) { // recurring appointments count from their first occurrence up to today
+            first = any ? std::min(first, rule.pattern.day) : rule.pattern.day;
+            last = any ? std::max(last, today) : today;
+            any = true;
+        }
+        if (!any) {
+            io.err << "Error: Nothing is booked yet" << std::endl;
+            return CommandResult::failed;
+        }
+    } else {
+        first = dateToDays(from);
+        last = to.empty() ? today : dateToDays(to);
+    }
+    bool named = from.empty() || from == "month" || from == "week" || from == "year" || from == "all";
+    if ((named && !to.empty()) || !extra.empty() || last < first) {
+        io.err << "Error: Invalid format. Use: report [week|month|year|all|<from> [to]] (from no later than to)" << std::endl;
+        return CommandResult::failed;
+    }
+    
+    // aggregated on a pool of its own, started with the first report (sessions and daemon connections share it)
+    static ThreadPool workers;
+    pager.ensureLoaded(first, last, appointments, index, arena);
+    ScheduleReport report = buildReport(appointments, index, rules, shopConfig(), first, last, &workers);
+    displayReport(io.view.frame, report, index);
+    showFrame(io);
+    return CommandResult::ok;
+}
+
+CommandResult Session::transactionCommand(cmdType command, CommandIO& io) {
+    if (io.shared) {
+        io.err << "Error: Transactions aren't available here; other clients' commands would run in the middle of one." << std::endl;
+        return CommandResult::failed;
+    }
+    if (command == cmdType::begin) {
+        if (inTransaction) {
+            io.err << "Error: A transaction is already open (commit or rollback it first)." << std::endl;
+            return CommandResult::failed;
+        }
+        inTransaction = true;
+        io.out << "Transaction started: changes are saved on commit, or taken back by rollback." << std::endl;
+        return CommandResult::ok;
+    }
+    if (!inTransaction) {
+        io.err << "Error: No transaction is open (start one with begin)." << std::endl;
+        return CommandResult::failed;
+    }
+    if (command == cmdType::rollback) {
+        size_t dropped = discardTransaction();
+        io.out << "Rolled back " << dropped << " change(s)." << std::endl;
+        return CommandResult::ok;
+    }
+    inTransaction = false;
+    size_t changes = pending.size();
+    std::string label = std::move(transactionLabel);
+    transactionLabel.clear();
+    if (!commitPending(label, io)) return CommandResult::failed;
+    io.out << "Committed " << changes << " change(s)." << std::endl;
+    return CommandResult::ok;
+}
+
+CommandResult Session::undoCommand(bool forward, CommandIO& io) {
+    const char* verb = forward ? "redo" : "undo";
+    if (io.shared) {
+        io.err << "Error: Nothing to " << verb << " here; the history would mix up other clients' changes." << std::endl;
+        return CommandResult::failed;
+    }
+    if (inTransaction) {
+        io.err << "Error: Commit or rollback the open transaction first." << std::endl;
+        return CommandResult::failed;
+    }
+    Transaction* last = forward ? history.redo() : history.undo();
+    if (!last) {
+        io.err << "Error: Nothing to " << verb << "." << std::endl;
+        return CommandResult::failed;
+    }
+    
+    std::vector<Step>& steps = last->steps;
+    auto replayAll = [&](bool ahead) { // undo goes through the steps backwards
+        if (ahead) {
+            for (Step& step : steps) replay(step, true);
+        } else {
+            for (auto step = steps.rbegin(); step != steps.rend(); ++step) replay(*step, false);
+        }
+    };
+    replayAll(forward);
+    if (!writeSteps(steps, forward, io)) { // nothing happens unless it can be saved
+        replayAll(!forward);
+        forward ? history.undo() : history.redo();
+        catchUp();
+        return CommandResult::failed;
+    }
+    
+    io.out << (forward ? "Redone: " : "Undone: ") << last->label << " (" << last->steps.size() << " change(s); "
+           << history.undoable() << " to undo, " << history.redoable() << " to redo)" << std::endl;
+    return CommandResult::ok;
+}
+
+CommandResult Session::statsCommand(const std::string& args, CommandIO& io) {
+    if (args == "reset") {
+        stats().reset();
+        io.out << "Stats reset." << std::endl;
+        return CommandResult::ok;
+    }
+    if (!args.empty()) {
+        io.err << "Error: Invalid format. Use: stats [reset]" << std::endl;
+        return CommandResult::failed;
+    }
+    stats().report(io.view.frame.stream(), filename);
+    showFrame(io);
+    return CommandResult::ok;
+}
+
+int runBatch(Session& session, std::istream& script) {
+    using Clock = std::chrono::steady_clock;
+    auto started = Clock::now();
+    session.beginBatch();
+    
+    size_t lineNumber = 0, ok = 0, failed = 0;
+    std::string line;
+    std::ostringstream out, err;
+    ViewState view;
+    CommandIO io{out, err, nullptr, view};
+    while (std::getline(script, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') continue; // blank lines and comments
+        line.erase(0, first);
+        
+        out.str("");
+        err.str("");
+        CommandResult result = session.execute(line, io);
+        if (result == CommandResult::exit) break;
+        
+        // summary: the command's first line of output, or its first error
+        std::string message = (result == CommandResult::ok ? out : err).str();
+        if (message.empty()) message = out.str();
+        size_t start = message.find_first_not_of('\n');
+        message = start == std::string::npos ? "" : message.substr(start, message.find('\n', start) - start);
+        std::cout << std::setw(6) << lineNumber << (result == CommandResult::ok ? "  ok      " : "  FAILED  ")
+                  << line << "  ->  " << message << '\n';
+        (result == CommandResult::ok ? ok : failed) += 1;
+    }
+    
+    session.close(); // the one save
+    double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    std::cout << "\n" << ok + failed << " command(s): " << ok << " ok, " << failed << " failed in "
+              << std::fixed << std::setprecision(3) << seconds * 1000 << " ms ("
+              << std::setprecision(0) << (ok + failed) / std::max(seconds, 1e-9) << " commands/s)" << std::endl;
+    return failed == 0 ? 0 : 2;
+}
+
+int runMirror(const std::string& filename, const LoadWindow& window, const std::string& view, int refreshSeconds, bool color) {
+    if (view != "daily" && view != "weekly" && view != "monthly") {
+        std::cerr << "Error: --mirror takes 'daily', 'weekly' or 'monthly'" << std::endl;
+        return 1;
+    }
+    Frame frame;
+    frame.color = color;
+    FrameDiff screen;
+    StoreWatcher watcher;
+    watcher.open(filename);
+    struct Loaded { // the store as of seen
+        TextArena arena;
+        std::vector<Appointment> appointments;
+        ScheduleIndex index;
+        DayPager pager;
+        std::vector<RecurrenceRule> rules;
+        StoreVersion seen;
+        std::vector<size_t> freeSlots; // slots removed by catch-up, so the ones shown keep their numbers
+    };
+    std::optional<Loaded> store;
+    while (true) {
+        if (watcher.changed()) { // always the first time round
+            StoreLock lock(filename, StoreLock::Mode::shared);
+            StoreVersion now = StoreVersion::of(filename);
+            std::vector<JournalRecord> records;
+            if (store && readJournalSince(filename, store->seen, store->arena, records)) {
+                // what was journaled since: days on screen get it now, the others when they are paged in
+                auto later = std::stable_partition(records.begin(), records.end(),
+                                                   [&](const JournalRecord& r) { return store->pager.hasDay(r.apt.day); });
+                std::for_each(later, records.end(), [&](const JournalRecord& r) { store->pager.defer(r); });
+                records.erase(later, records.end());
+                applyJournal(records, store->appointments, store->index, store->freeSlots);
+                if (!now.sameRules(store->seen)) store->rules = loadRules(filename + ".rules", store->arena);
+                store->seen.rulesInode = now.rulesInode;
+                store->seen.rulesModified = now.rulesModified;
+            } else { // the first time, or what was written since was compacted before it could be read
+                store.emplace();
+                try {
+                    recoverAppointments(store->appointments, store->index, store->pager, filename, store->arena, window, true, &store->seen);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: " << e.what() << std::endl;
+                    return 1;
+                }
+                store->rules = loadRules(filename + ".rules", store->arena);
+            }
+        }
+        TextArena& arena = store->arena;
+        std::vector<Appointment>& appointments = store->appointments;
+        ScheduleIndex& index = store->index;
+        DayPager& pager = store->pager;
+        const std::vector<RecurrenceRule>& rules = store->rules;
+        
+        int today = getCurrentDay();
+        if (view == "daily") {
+            pager.ensureLoaded(today, today, appointments, index, arena);
+            ScheduleWindow schedule(appointments, index, rules, today, today);
+            displayDailySchedule(frame, schedule.appointments(), schedule.index(), daysToDate(today));
+        } else if (view == "weekly") {
+            int weekStart = weekStartFromDays(today);
+            pager.ensureLoaded(weekStart, weekStart + 6, appointments, index, arena);
+            ScheduleWindow schedule(appointments, index, rules, weekStart, weekStart + 6);
+            displayWeeklySchedule(frame, schedule.appointments(), schedule.index(), daysToDate(weekStart));
+        } else {
+            CivilDate date = civilFromDays(today);
+            int monthStart = daysFromCivil(date.year, date.month, 1);
+            pager.ensureLoaded(monthStart, monthStart + 30, appointments, index, arena);
+            ScheduleWindow schedule(appointments, index, rules, monthStart, monthStart + 30);
+            displayMonthlySchedule(frame, schedule.index(), monthStart);
+        }
+        
+        writeStdout(screen.update(frame.str()));
+        frame.clear();
+        watcher.wait(refreshSeconds * 1000); // redrawn anyway now and then, for when the day turns over
+    }
+}
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <istream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "history.h"
+#include "journal.h"
+#include "lineeditor.h"
+#include "prefixtrie.h"
+#include "render.h"
+#include "schedule.h"
+#include "stats.h"
+#include "storage.h"
+#include "storewatch.h"
+#include "waitlist.h"
+
+enum class cmdType {
+    exit, //exit the program
+    add,    //add a new appointment
+    del,    //delete an appointment
+    reschedule, //reschedule existing appointment
+    display, //display all appointments
+    client, //list all appointments of one client
+    repeat, //add, list or end recurring appointments
+    stats, //show how long commands and store I/O take
+    slots, //suggest the best free slots over the coming days
+    report, //utilization, busiest hours, service mix and gaps over a range of days
+    wait, //put a client on the waitlist for a cancellation, list it or take them off
+    begin, //start a transaction: the commands after it apply together or not at all
+    commit, //apply the open transaction
+    rollback, //drop the open transaction
+    undo, //take back the last change (a command, or a whole transaction)
+    redo, //apply the last undone change again
+    help //show help information
+};
+
+cmdType getCommandCode(const std::string& input); // Map string commands to enum values for easier switch-case handling (as strings can't be used in switch)
+
+// display help info and how to use commands
+void displayHelp(std::ostream& out);
+
+// Outcome of one command line
+enum class CommandResult { ok, failed, exit };
+
+// What one user of the views has on screen: the frame views are composed in, and where weekly/monthly
+// navigation currently is. Each prompt or connection has its own
+struct ViewState {
+    Frame frame;
+    std::string weekStart = getWeekStart(); // where 'display weekly next/prev' navigates from
+    int month = currentMonthNumber();       // where 'display monthly next/prev' navigates from
+};
+
+// Where a command writes its output and asks its questions. prompt is null when there is nobody to
+// ask (batch mode), in which case a command that needs a choice cancels instead. shared is set when other
+// users' commands run between this one's (the daemon), where transactions and undo aren't available
+struct CommandIO {
+    std::ostream& out;
+    std::ostream& err;
+    std::istream* prompt;
+    ViewState& view;
+    bool shared = false;
+};
+
+// One open store and everything built from it: the loaded appointments, their index, the pager and the journal.
+// Runs command lines for the prompt and for batch mode
+class Session {
+public:
+    // recover the store and open its journal; false (after reporting why) if the store can't be read
+    // chairs are the shop's resources in order; unassigned bookings go on the first. Empty for a one-chair shop
+    bool open(const std::string& file, const LoadWindow& window, const std::vector<std::string>& chairs);
+    
+    // run one command line; output, errors and questions go through io
+    CommandResult execute(const std::string& input, CommandIO& io);
+    
+    // make the changes so far durable (one fsync), compacting in the background once the journal is long
+    void commit();
+    
+    const std::string& storeName() const { return filename; }
+    
+    // how suggested slots are ranked when a day is full (and by 'slots' unless it is told otherwise)
+    void setSlotRanking(const SlotRanking& ranking) { slotRanking = ranking; }
+    
+    // the shop's chairs (resource ids 0..chairCount()-1)
+    int chairCount() const { return index.resourceCount(); }
+    std::string_view chairName(int resource) const { return index.resourceName(resource); }
+    int findChair(std::string_view name) const { return index.findResource(name); }
+    
+    // the best free slots for search, with the days it covers paged in and recurring occurrences counted as booked
+    std::vector<SlotCandidate> bestSlots(const SlotSearch& search);
+    
+    // read the arguments of 'slots' ("<service> [date] [earliest|fit|<from>-<to>] [@chair]") into search;
+    // false (after reporting it) if they don't make sense
+    bool parseSlotSearch(std::string args, SlotSearch& search, CommandIO& io) const;
+    
+    // every booking on days first..last, recurring occurrences included, with the days paged in. Their dates
+    // are copied into text, since an occurrence's date lives only as long as the window it was expanded in
+    std::vector<Appointment> bookingsBetween(int first, int last, TextArena& text);
+    
+    // what Tab completes at cursor: a command, client, service, chair or keyword, depending on where it is
+    Completion complete(const std::string& line, size_t cursor);
+    
+    // commands that only read the schedule, so the daemon can run them side by side
+    static bool readsOnly(const std::string& input);
+    
+    // page in every day, so that read-only commands never have to (the daemon keeps it all in memory)
+    void loadAll();
+    
+    // catch up with what other processes sharing the store changed since: their journal records are applied (or
+    // wait in the pager until their days are paged in) and changed rules are read again. The undo history is
+    // cleared when anything came in, since it was recorded against a different schedule. Does nothing while a
+    // transaction is open; true if anything changed
+    bool refresh();
+    
+    // whether refresh() has anything to catch up with: the watcher saw the store's files change and they aren't
+    // at the version this process last wrote or caught up with. Leaves the schedule alone, so the daemon can ask
+    // without holding up its readers
+    bool stale();
+    
+    // refresh() without asking the watcher first
+    bool catchUp();
+    
+    // becomes readable when the store's files change, for poll(); -1 when refresh() has to be called now and then
+    int watchFd() const { return watcher.pollFd(); }
+    
+    // hold journal records until the next commit(), however many there are, and the store's lock until close()
+    // (batch mode): other processes wait for the batch instead of every command checking for them
+    void beginBatch();
+    
+    // fold the journal into the snapshot so the file is complete on its own (a transaction left open is rolled back)
+    void close();
+    
+    // views go straight to the terminal in one write; anywhere else (batch output, a socket) through the stream
+    static void showFrame(CommandIO& io);
+    
+private:
+    static constexpr int anyDay = std::numeric_limits<int>::min();
+    static constexpr size_t noRule = static_cast<size_t>(-1);
+    static constexpr int ruleCheckDays = 26 * 7; // how far ahead a new recurring rule is checked for clashes
+    static constexpr size_t undoDepth = 100; // changes 'undo' can go back
+    static constexpr int waitDays = 14; // how long a waitlist entry without dates waits, from today
+    static constexpr size_t waitlistSlack = 64; // records the waitlist file may have past twice those waiting
+    
+    // One change a command made to the schedule, with what it takes to reverse it: an appointment booked
+    // into or taken out of slot, rules[rule] going from before to after (nullopt: the rule isn't there), or a
+    // waitlist entry leaving (waitingBefore) or joining (waitingAfter)
+    struct Step {
+        enum class Op { book, unbook, rule, wait };
+        Op op = Op::book;
+        Appointment apt;
+        size_t slot = 0;
+        size_t rule = 0;
+        std::optional<RecurrenceRule> before, after;
+        std::optional<WaitlistEntry> waitingBefore, waitingAfter;
+    };
+    
+    // The steps of one command, or of every command between begin and commit: what undo and redo replay
+    struct Transaction {
+        std::string label; // the command line(s), for messages
+        std::vector<Step> steps;
+    };
+    
+    // page in one date before it is searched or booked (no-op when everything is loaded)
+    void ensureDate(std::string_view date);
+    
+    // days first..last (already paged in) with the recurring occurrences expanded
+    ScheduleWindow window(int first, int last) const;
+    
+    bool saveRules() const { return ::saveRules(rules, filename + ".rules"); }
+    
+    // the waitlist file read again (at open, and when another process rewrote it); seen's waitlist part moves up
+    // to it. truncateTorn cuts off a record torn by a crash, at open
+    void loadWaitlist(bool truncateTorn = false);
+    
+    // the waitlist records another process appended since seen, applied (call with the store locked)
+    void catchUpWaitlist(const StoreVersion& now);
+    
+    // rewrite the waitlist file with just the clients still waiting, the expired ones taken off first (call with
+    // the store locked, and up to date with it); false if it couldn't be written
+    bool compactWaitlist();
+    
+    // index the clients of appointments the pager appended since the last call
+    void indexNewClients();
+    
+    // add/remove an appointment in the list and in both indexes, recorded as a step of the current command.
+    // changeRule does the same for rules[rule] (rules.size() to add one, nullopt to remove it), and
+    // changeWaitlist for a waitlist entry (before leaving, after joining)
+    size_t book(const Appointment& apt);
+    void unbook(size_t slot);
+    void changeRule(size_t rule, std::optional<RecurrenceRule> after);
+    void changeWaitlist(std::optional<WaitlistEntry> before, std::optional<WaitlistEntry> after);
+    
+    // the same changes without recording them; applyBook puts apt back into slot if that one is free
+    size_t applyBook(const Appointment& apt, size_t slot = ScheduleIndex::noSlot);
+    void applyUnbook(size_t slot);
+    void applyRule(size_t rule, const std::optional<RecurrenceRule>& from, const std::optional<RecurrenceRule>& to);
+    void applyWaitlist(const std::optional<WaitlistEntry>& from, std::optional<WaitlistEntry>& to);
+    
+    // do a step again (forward) or reverse it
+    void replay(Step& step, bool forward);
+    
+    // the journal records for applying steps (forward), or for reversing them
+    void journalSteps(const std::vector<Step>& steps, bool forward);
+    
+    // the same for the steps' waitlist changes, appended to the waitlist file (or the file rewritten, when it is
+    // mostly clients who left by now); false if it couldn't be written
+    bool journalWaitlist(const std::vector<Step>& steps, bool forward);
+    
+    // reverse the pending steps after mark, newest first (a failed command, or a rolled back transaction)
+    void rollbackTo(size_t mark);
+    
+    // make the pending steps permanent: save the rules if they changed, journal the appointments in one go
+    // and remember them for undo. false (after rolling them back) if the rules can't be saved or another
+    // process changed the store in the meantime
+    bool commitPending(const std::string& label, CommandIO& io);
+    
+    // write steps (forward, or reversed) to the store: the rules if any step changed them and the journal records,
+    // with the store locked and only if no other process wrote to it since this one last caught up. false (after
+    // reporting it, with nothing written) if one did or the rules can't be saved
+    bool writeSteps(const std::vector<Step>& steps, bool forward, CommandIO& io);
+    
+    // the store's lock for one read or write; none when a batch holds it already
+    std::unique_ptr<StoreLock> lockStore(StoreLock::Mode mode = StoreLock::Mode::exclusive) const {
+        return batchLock ? nullptr : std::make_unique<StoreLock>(filename, mode);
+    }
+    
+    // whether another process changed what the store holds since seen (call with the store locked). A journal
+    // that was only compacted meanwhile doesn't count; seen just moves on to the new one
+    bool othersWrote();
+    
+    // one journal record another process wrote, applied to the loaded schedule like replay applies a step
+    void applyRecord(const JournalRecord& record);
+    
+    // load the store again from scratch, when what another process wrote was compacted away before it was read
+    void reload();
+    
+    // roll back an open transaction; how many changes it had
+    size_t discardTransaction();
+    
+    // every live appointment of a client, any capitalization; the first lookup pages in all days
+    const std::vector<size_t>* clientSlots(std::string_view name);
+    
+    // slot of name's appointment at start (on onDay, if given): today's or the next upcoming one, else the latest
+    // before today. Pages in everything if it isn't among the loaded days. ScheduleIndex::noSlot if there is none
+    size_t findAppointment(const std::string& name, int start, int onDay = anyDay);
+    
+    // What "name time [date]" refers to: a stored appointment, or one occurrence of a recurring rule
+    struct Target {
+        size_t slot = ScheduleIndex::noSlot;
+        size_t rule = noRule;
+        int day = 0; // the occurrence's day
+        bool found() const { return slot != ScheduleIndex::noSlot || rule != noRule; }
+    };
+    
+    // like findAppointment, but also looks at the occurrences of name's recurring rules at start; without a
+    // day, whichever of the two comes next from today wins
+    Target findTarget(const std::string& name, int start, int onDay = anyDay);
+    
+    // rules that belong to name, in the order they were added
+    std::vector<size_t> clientRules(std::string_view name) const;
+    
+    // pull an "@chair" token out of args; false (after reporting it) if the chair isn't one of the shop's
+    bool takeResource(std::string& args, int& resource, CommandIO& io) const;
+    
+    // whether apt can be written to the store: a binary one has fixed-width fields. false (after reporting it) if
+    // not, so the command fails before anything is journaled rather than every compaction after it
+    bool fitsStore(const Appointment& apt, CommandIO& io) const;
+    
+    // chair apt (normalized, resource ignored) can go on: requested if it is free there, otherwise (when
+    // requested is -1) preferred or else the first free chair. -1 if the time is taken everywhere it may go
+    int freeResource(const ScheduleWindow& schedule, const Appointment& apt, int requested, int preferred) const;
+    
+    // the booking (or recurring occurrence) apt would collide with on resource
+    static const Appointment* conflictOn(const ScheduleWindow& schedule, const Appointment& apt, int resource);
+    
+    // " on <chair>" for messages, only when the shop has more than one
+    std::string onChair(int resource) const;
+    
+    // apt's date is full: offer the best slots on the days after it, ranked, or an after-hours booking on the date
+    // itself. Fills in apt's date and time and the chair for the one picked; false if cancelled or nothing fits
+    bool chooseAlternative(Appointment& apt, int chair, int& resource, const char* cancelled, CommandIO& io);
+    
+    // freed (day, start and duration set) was just taken off resource's timeline by a cancellation: book
+    // whoever on the waitlist fits best into the free stretch around it, then the next one into what is left,
+    // as steps of the same command (so undoing the cancellation undoes the bookings too)
+    void backfill(const Appointment& freed, int resource, CommandIO& io);
+    
+    // book the best waitlist match into the free stretch [start, end) of resource on day, over the freed time
+    // [from, to) and as close to its start as it can, then again into what is left of it on either side
+    void fillGap(int resource, int day, int start, int end, int from, int to, CommandIO& io);
+    
+    CommandResult addCommand(std::string args, CommandIO& io);
+
+    CommandResult delCommand(const std::string& args, CommandIO& io);
+
+    CommandResult rescheduleCommand(std::string args, CommandIO& io);
+
+    CommandResult displayCommand(const std::string& args, CommandIO& io);
+    
+    CommandResult clientCommand(const std::string& args, CommandIO& io);
+    
+    CommandResult repeatCommand(std::string args, CommandIO& io);
+    
+    // "repeat end name time [lastDate]": no occurrences after lastDate (default: none from today on).
+    // A rule that ends before it starts is dropped altogether
+    CommandResult endRule(std::istringstream& iss, CommandIO& io);
+    
+    CommandResult listRules(CommandIO& io);
+    
+    // "wait <name> <service> [first] [last] [<from>-<to>] [priority] [@chair]": wait for a cancellation.
+    // Or "list", or "drop name"
+    CommandResult waitCommand(std::string args, CommandIO& io);
+    
+    CommandResult listWaitlist(CommandIO& io);
+    
+    // "on <date>" or "from <first> to <last>", and the hours if the entry has any
+    static std::string describeWait(const WaitlistEntry& entry);
+    
+    CommandResult statsCommand(const std::string& args, CommandIO& io);
+    
+    // "slots <service> [date] [earliest|fit|<from>-<to>] [@chair]": the best free slots over the next two weeks
+    CommandResult slotsCommand(std::string args, CommandIO& io);
+    
+    // "report [week|month|year|all|<from> [to]]": how the shop did over a range of days (default: this month)
+    CommandResult reportCommand(const std::string& args, CommandIO& io);
+    
+    // begin / commit / rollback of a multi-command transaction
+    CommandResult transactionCommand(cmdType command, CommandIO& io);
+    
+    // undo (forward false) or redo the last change
+    CommandResult undoCommand(bool forward, CommandIO& io);
+    
+    std::string filename;
+    LoadWindow loadWindow; // what open() was asked to load, for reload()
+    std::vector<std::string> chairNames;
+    TextArena arena; // owns the text of every appointment (must outlive appointments)
+    std::vector<Appointment> appointments; // store appointments
+    ScheduleIndex index; // per-date lookup of booked intervals
+    DayPager pager; // pages days in from the snapshot as they are needed
+    ClientIndex clients; // client name -> slots
+    size_t clientsIndexed = 0; // appointments[0 .. clientsIndexed) are in clients
+    std::vector<size_t> freeSlots; // tombstoned slots, reused by the next add
+    std::vector<RecurrenceRule> rules; // recurring appointments, expanded per view (saved in "<store>.rules")
+    Waitlist waitlist; // clients waiting for a cancellation (journaled in "<store>.waitlist")
+    size_t waitlistRecords = 0; // in the waitlist file, to rewrite it once it is mostly clients who left
+    SlotRanking slotRanking;
+    PrefixTrie serviceNames; // the catalog's names and aliases, for completion
+    std::vector<Step> pending; // steps of the running command or the open transaction, not journaled yet
+    bool inTransaction = false; // between begin and commit/rollback
+    std::string transactionLabel; // the command lines of the open transaction that changed something
+    UndoHistory<Transaction> history{undoDepth};
+    Journal journal;
+    Compactor compactor;
+    StoreWatcher watcher; // other processes' changes to the store
+    StoreVersion seen; // the store as this process last wrote or caught up with it
+    std::unique_ptr<StoreLock> batchLock; // held from beginBatch() to close()
+};
+
+// Batch mode (MirrorBooking --batch <script|->): run every line of a script as one transaction.
+// Changes are checked against the in-memory index as they go, written to the journal with a single
+// fsync at the end and then folded into the store in one save. Prints one result line per command
+// and the overall throughput
+int runBatch(Session& session, std::istream& script);
+
+// Mirror mode (MirrorBooking --mirror daily|weekly|monthly): a read-only dashboard for a screen that shows
+// nothing else. The view is redrawn when the store changes (what was journaled since is applied, not the whole
+// store reloaded) and every refreshSeconds for when the day turns over; only the lines that changed are written
+int runMirror(const std::string& filename, const LoadWindow& window, const std::string& view, int refreshSeconds, bool color);
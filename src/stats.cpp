@@ -0,0 +1,118 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+std::uint64_t LatencyHistogram::percentile(double p) const {
+    std::uint64_t n = count();
+    if (n == 0) return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(p * static_cast<double>(n) + 0.999999); // ceil, at least 1
+    if (rank == 0) rank = 1;
+    std::uint64_t seen = 0;
+    for (int bucket = 0; bucket < bucketCount; ++bucket) {
+        seen += buckets[bucket].load(std::memory_order_relaxed);
+        if (seen < rank) continue;
+        if (bucket < subBuckets) return static_cast<std::uint64_t>(bucket);
+        int exponent = bucket / subBuckets + 2;
+        std::uint64_t width = std::uint64_t(1) << (exponent - 3);
+        std::uint64_t low = static_cast<std::uint64_t>(subBuckets + bucket % subBuckets) << (exponent - 3);
+        return std::min(low + width / 2, maxNanos());
+    }
+    return maxNanos(); // a sample landed after count() was read
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    samples.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    longest.store(0, std::memory_order_relaxed);
+}
+
+// "850ns", "12.3us", "4.56ms", "1.20s"
+static std::string formatNanos(std::uint64_t nanos) {
+    std::ostringstream text;
+    text << std::fixed;
+    if (nanos < 1000) {
+        text << nanos << "ns";
+    } else if (nanos < 1000000) {
+        text << std::setprecision(1) << nanos / 1e3 << "us";
+    } else if (nanos < 1000000000) {
+        text << std::setprecision(2) << nanos / 1e6 << "ms";
+    } else {
+        text << std::setprecision(2) << nanos / 1e9 << "s";
+    }
+    return text.str();
+}
+
+static void reportRow(std::ostream& out, std::string_view name, const LatencyHistogram& histogram) {
+    std::uint64_t n = histogram.count();
+    out << std::left << std::setw(14) << name << std::right << std::setw(8) << n;
+    if (n > 0) {
+        out << std::setw(10) << formatNanos(histogram.totalNanos() / n) << std::setw(10) << formatNanos(histogram.percentile(0.50))
+            << std::setw(10) << formatNanos(histogram.percentile(0.95)) << std::setw(10) << formatNanos(histogram.percentile(0.99))
+            << std::setw(10) << formatNanos(histogram.maxNanos());
+    }
+    out << '\n';
+}
+
+static void reportFile(std::ostream& out, const std::string& label, const std::string& path) {
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(path, ec);
+    out << std::left << std::setw(14) << label << std::right << std::setw(12);
+    if (ec) {
+        out << "-" << "        " << path << " (none)\n";
+    } else {
+        out << size << " bytes  " << path << '\n';
+    }
+}
+
+void Stats::report(std::ostream& out, const std::string& storeFile) const {
+    auto uptime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - since).count();
+    out << "\n=====  Stats (last " << uptime / 60 << "m " << uptime % 60 << "s)  =====\n" << '\n';
+    out << std::left << std::setw(14) << "command" << std::right << std::setw(8) << "count" << std::setw(10) << "mean"
+        << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << '\n';
+    for (size_t i = 0; i < commandCount; ++i) {
+        if (commands[i].count() > 0) reportRow(out, commandNames[i], commands[i]);
+    }
+    out << '\n';
+    out << "i/o" << '\n';
+    reportRow(out, "startup", startup);
+    reportRow(out, "load", load);
+    reportRow(out, "save", save);
+    reportRow(out, "journal sync", journalSync);
+    out << '\n';
+    std::uint64_t snapshot = snapshotBytes.load(std::memory_order_relaxed);
+    std::uint64_t journal = journalBytes.load(std::memory_order_relaxed);
+    out << std::left << std::setw(14) << "bytes written" << std::right << std::setw(12) << snapshot + journal
+        << " (snapshots " << snapshot << ", journal " << journal << ")\n";
+    reportFile(out, "store", storeFile);
+    reportFile(out, "journal", storeFile + ".journal");
+    reportFile(out, "rules", storeFile + ".rules");
+    out << std::left;
+}
+
+bool Stats::saveReport(const std::string& path, const std::string& storeFile) const {
+    std::ofstream file(path);
+    report(file, storeFile);
+    return static_cast<bool>(file.flush());
+}
+
+void Stats::reset() {
+    for (auto& histogram : commands) histogram.reset();
+    startup.reset();
+    load.reset();
+    save.reset();
+    journalSync.reset();
+    snapshotBytes.store(0, std::memory_order_relaxed);
+    journalBytes.store(0, std::memory_order_relaxed);
+    since = std::chrono::steady_clock::now();
+}
+
+Stats& stats() {
+    static Stats processStats;
+    return processStats;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Latency histogram with fixed log-linear buckets: exact below 8ns, then 8 buckets per power of two, so a
+// percentile read from it is within 12.5% of the real one. Recording is a few relaxed atomic increments
+// (no locks, no allocation), cheap enough to leave on and safe from the daemon's reader threads
+class LatencyHistogram {
+public:
+    static constexpr int subBuckets = 8;
+    static constexpr int bucketCount = 62 * subBuckets; // up to 2^64 ns
+
+    void record(std::uint64_t nanos) {
+        buckets[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(nanos, std::memory_order_relaxed);
+        std::uint64_t seen = longest.load(std::memory_order_relaxed);
+        while (nanos > seen && !longest.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {}
+    }
+
+    std::uint64_t count() const { return samples.load(std::memory_order_relaxed); }
+    std::uint64_t totalNanos() const { return total.load(std::memory_order_relaxed); }
+    std::uint64_t maxNanos() const { return longest.load(std::memory_order_relaxed); }
+
+    // latency at or below which fraction p (0..1) of the samples fall, in ns (middle of its bucket); 0 if empty
+    std::uint64_t percentile(double p) const;
+
+    void reset();
+
+private:
+    static int bucketOf(std::uint64_t nanos) {
+        if (nanos < subBuckets) return static_cast<int>(nanos);
+        int exponent = 63;
+        while (!(nanos >> exponent)) --exponent; // highest set bit (>= 3 here)
+        int sub = static_cast<int>(nanos >> (exponent - 3)) - subBuckets;
+        return (exponent - 2) * subBuckets + sub;
+    }
+
+    std::array<std::atomic<std::uint64_t>, bucketCount> buckets{};
+    std::atomic<std::uint64_t> samples{0};
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> longest{0};
+};
+
+// Records the time from construction to destruction into a histogram (steady_clock, so wall-clock changes don't skew it)
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Where the time goes in this process: one histogram per command, one per kind of store I/O and the bytes
+// written to disk. There is one set per process (stats()), filled in by Session, the storage functions and the journal
+class Stats {
+public:
+    static constexpr std::string_view commandNames[] = {"add", "del", "reschedule", "display", "client", "repeat",
+                                                        "slots", "report", "begin", "commit", "rollback", "undo", "redo", "stats",
+                                                        "help", "exit", "other"};
+    static constexpr size_t commandCount = sizeof(commandNames) / sizeof(commandNames[0]);
+
+    // the histogram of a command line's first word; anything unknown counts as "other"
+    LatencyHistogram& command(std::string_view name) {
+        for (size_t i = 0; i + 1 < commandCount; ++i) {
+            if (commandNames[i] == name) return commands[i];
+        }
+        return commands[commandCount - 1];
+    }
+
+    LatencyHistogram startup;     // opening a store: recovery, journal replay and the initial load window
+    LatencyHistogram load;        // whole-snapshot loads (text or binary), including background compactions
+    LatencyHistogram save;        // whole-snapshot saves, temp file through fsync and rename
+    LatencyHistogram journalSync; // the fsync that commits a command's journal records
+    std::atomic<std::uint64_t> snapshotBytes{0}; // written by snapshot saves
+    std::atomic<std::uint64_t> journalBytes{0};  // appended to the journal
+
+    // the report the stats command prints: per-command counts and p50/p95/p99/max latency, I/O, bytes
+    // written, and the size of storeFile and its journal and rules files
+    void report(std::ostream& out, const std::string& storeFile) const;
+
+    // write report() to path (on exit, for --stats); false if it can't be written
+    bool saveReport(const std::string& path, const std::string& storeFile) const;
+
+    void reset();
+
+private:
+    std::array<LatencyHistogram, commandCount> commands;
+    std::chrono::steady_clock::time_point since = std::chrono::steady_clock::now();
+};
+
+Stats& stats();
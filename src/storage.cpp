@@ -0,0 +1,486 @@
+#include "storage.h"
+#include "stats.h"
+
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+        opened = true;
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                bytes = static_cast<const char*>(mapping);
+                mapped = true;
+            } else {
+                opened = false;
+                length = 0;
+            }
+        }
+    }
+    ::close(fd);
+    if (mapped) madvise(const_cast<char*>(bytes), length, MADV_SEQUENTIAL);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return;
+    opened = true;
+    length = static_cast<size_t>(file.tellg());
+    buffer.reset(new char[length ? length : 1]);
+    file.seekg(0);
+    file.read(buffer.get(), static_cast<std::streamsize>(length));
+    bytes = buffer.get();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (mapped) munmap(const_cast<char*>(bytes), length);
+#endif
+}
+
+bool parseAppointmentRecord(std::string_view line, Appointment& apt) {
+    std::string_view* fields[] = {&apt.name, &apt.time, &apt.date, &apt.service};
+    for (std::string_view* field : fields) {
+        size_t bar = line.find('|');
+        if (bar == std::string_view::npos) return false;
+        *field = line.substr(0, bar);
+        line.remove_prefix(bar + 1);
+    }
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1); // files edited on Windows
+    
+    auto result = std::from_chars(line.data(), line.data() + line.size(), apt.duration);
+    if (result.ec != std::errc()) return false;
+    if (result.ptr != line.data() + line.size()) { // optional resource field (older files don't have one)
+        if (*result.ptr != '|') return false;
+        apt.resource = line.substr(result.ptr - line.data() + 1);
+    }
+    try {
+        normalizeAppointment(apt); // parse time/date/service once, up front
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+void internAppointment(Appointment& apt, TextArena& arena) {
+    apt.name = arena.intern(apt.name);
+    apt.time = arena.intern(apt.time);
+    apt.date = arena.intern(apt.date);
+    apt.service = arena.intern(apt.service);
+    apt.resource = arena.intern(apt.resource);
+}
+
+std::string formatAppointmentRecord(const Appointment& apt) {
+    std::string record;
+    record.reserve(apt.name.size() + apt.time.size() + apt.date.size() + apt.service.size() + apt.resource.size() + 16);
+    record.append(apt.name).append(1, '|').append(apt.time).append(1, '|')
+          .append(apt.date).append(1, '|').append(apt.service).append(1, '|')
+          .append(std::to_string(apt.duration));
+    if (!apt.resource.empty()) record.append(1, '|').append(apt.resource);
+    return record;
+}
+
+void loadAppointments(std::vector<Appointment>& appointments, const std::string& filename, TextArena& arena) {
+    ScopedTimer timer(stats().load);
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        return; // file doesn't exist yet
+    }
+    std::string_view text = arena.adopt(std::move(file));
+    // one record per line: sized once up front instead of doubling (and copying) twenty times for a big store
+    appointments.reserve(appointments.size() + static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) + 1);
+    
+    auto parseLine = [&](std::string_view line) { // each line represents an appointment, using '|' as delimiter to separate fields
+        if (line.empty() || line == "\r") return;
+        Appointment apt;
+        if (!parseAppointmentRecord(line, apt)) {
+            std::cerr << "Warning: skipping malformed appointment record: " << line << std::endl;
+            return;
+        }
+        appointments.push_back(apt); // add to appointments list
+    };
+    size_t consumed = forEachLine(text, parseLine);
+    if (consumed < text.size()) parseLine(text.substr(consumed)); // last line without a trailing newline
+}
+
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+void syncDirectory(const std::string& dir) {
+#ifndef _WIN32
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)dir;
+#endif
+}
+
+bool saveAppointments(const std::vector<Appointment>& appointments, const std::string& filename) {
+    ScopedTimer timer(stats().save);
+    const std::string tmpName = filename + ".tmp";
+    std::FILE* file = std::fopen(tmpName.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Error: Could not open file for writing." << std::endl;
+        return false;
+    }
+    
+    bool ok = true;
+    std::uint64_t written = 0;
+    for (const auto& apt : appointments) {
+        std::string record = formatAppointmentRecord(apt);
+        record += '\n';
+        if (std::fwrite(record.data(), 1, record.size(), file) != record.size()) {
+            ok = false;
+            break;
+        }
+        written += record.size();
+    }
+    stats().snapshotBytes.fetch_add(written, std::memory_order_relaxed);
+    ok = syncFile(file) && ok;
+    ok = (std::fclose(file) == 0) && ok;
+    
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmpName, filename, ec);
+    if (!ok || ec) {
+        std::cerr << "Error: Could not write " << filename << std::endl;
+        std::filesystem::remove(tmpName, ec);
+        return false;
+    }
+    syncDirectory(std::filesystem::path(filename).parent_path().string());
+    return true;
+}
+
+// write text to path atomically: a synced temp file renamed over it
+static bool writeWhole(const std::string& text, const std::string& path) {
+    std::error_code ec;
+    const std::string tmpName = path + ".tmp";
+    std::FILE* file = std::fopen(tmpName.c_str(), "wb");
+    bool ok = file && std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (file) {
+        ok = syncFile(file) && ok;
+        ok = (std::fclose(file) == 0) && ok;
+    }
+    if (ok) std::filesystem::rename(tmpName, path, ec);
+    if (!ok || ec) {
+        std::cerr << "Error: Could not write " << path << std::endl;
+        std::filesystem::remove(tmpName, ec);
+        return false;
+    }
+    syncDirectory(std::filesystem::path(path).parent_path().string());
+    return true;
+}
+
+std::vector<RecurrenceRule> loadRules(const std::string& path, TextArena& arena) {
+    std::vector<RecurrenceRule> rules;
+    std::string text; // loaded again whenever another process changes it: only the fields are kept, interned
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return rules;
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        text = contents.str();
+    }
+    
+    forEachLine(text, [&](std::string_view line) {
+        if (line.empty() || line == "\r") return;
+        RecurrenceRule rule;
+        std::string_view fields[3];
+        std::string_view rest = line;
+        bool ok = true;
+        for (auto& field : fields) {
+            size_t bar = rest.find('|');
+            if (bar == std::string_view::npos) {
+                ok = false;
+                break;
+            }
+            field = rest.substr(0, bar);
+            rest.remove_prefix(bar + 1);
+        }
+        try {
+            ok = ok && std::from_chars(fields[0].data(), fields[0].data() + fields[0].size(), rule.weeks).ec == std::errc() &&
+                 rule.weeks > 0 && parseAppointmentRecord(rest, rule.pattern);
+            if (ok && fields[1] != "-") rule.lastDay = dateToDays(fields[1]);
+            for (std::string_view list = fields[2]; ok && !list.empty();) {
+                size_t comma = list.find(',');
+                rule.cancelled.push_back(dateToDays(list.substr(0, comma)));
+                list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+            }
+        } catch (const std::exception&) {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Warning: skipping malformed recurring rule: " << line << std::endl;
+            return;
+        }
+        std::sort(rule.cancelled.begin(), rule.cancelled.end());
+        internAppointment(rule.pattern, arena);
+        rules.push_back(std::move(rule));
+    });
+    return rules;
+}
+
+bool saveRules(const std::vector<RecurrenceRule>& rules, const std::string& path) {
+    std::error_code ec;
+    if (rules.empty()) {
+        std::filesystem::remove(path, ec);
+        return !ec;
+    }
+    std::string text;
+    for (const auto& rule : rules) {
+        text += std::to_string(rule.weeks);
+        text += '|';
+        text += rule.lastDay == RecurrenceRule::openEnded ? std::string("-") : daysToDate(rule.lastDay);
+        text += '|';
+        for (size_t i = 0; i < rule.cancelled.size(); ++i) {
+            if (i > 0) text += ',';
+            text += daysToDate(rule.cancelled[i]);
+        }
+        text += '|';
+        text += formatAppointmentRecord(rule.pattern);
+        text += '\n';
+    }
+    return writeWhole(text, path);
+}
+
+// one "op|priority|lastDate|to|record" line of the waitlist file (no newline)
+static std::string formatWaitlistRecord(char op, const WaitlistEntry& entry) {
+    std::string line(1, op);
+    line += '|';
+    line += std::to_string(entry.priority);
+    line += '|';
+    line += daysToDate(entry.lastDay);
+    line += '|';
+    line += entry.to == minutesPerDay ? std::string("-") : minutesToTime(entry.to);
+    line += '|';
+    line += formatAppointmentRecord(entry.request);
+    return line;
+}
+
+size_t readWaitlist(const std::string& path, size_t offset, TextArena& arena, std::vector<WaitlistRecord>& records,
+                    bool truncateTorn) {
+    std::string text; // read again and again as others append to it: only the fields are kept, interned
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return offset;
+        file.seekg(static_cast<std::streamoff>(offset));
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        text = contents.str();
+    }
+    
+    size_t consumed = forEachLine(text, [&](std::string_view line) {
+        if (line.empty() || line == "\r") return;
+        WaitlistRecord record;
+        std::string_view fields[4];
+        std::string_view rest = line;
+        bool ok = true;
+        for (auto& field : fields) {
+            size_t bar = rest.find('|');
+            if (bar == std::string_view::npos) {
+                ok = false;
+                break;
+            }
+            field = rest.substr(0, bar);
+            rest.remove_prefix(bar + 1);
+        }
+        WaitlistEntry& entry = record.entry;
+        try {
+            ok = ok && (fields[0] == "+" || fields[0] == "-") &&
+                 std::from_chars(fields[1].data(), fields[1].data() + fields[1].size(), entry.priority).ec == std::errc() &&
+                 parseAppointmentRecord(rest, entry.request);
+            if (ok) entry.lastDay = dateToDays(fields[2]);
+            if (ok && fields[3] != "-") entry.to = timeToMinutes(fields[3]);
+        } catch (const std::exception&) {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Warning: skipping malformed waitlist record: " << line << std::endl;
+            return;
+        }
+        record.op = fields[0][0];
+        internAppointment(entry.request, arena);
+        records.push_back(std::move(record));
+    });
+    if (truncateTorn && consumed < text.size()) {
+        std::error_code ec;
+        std::filesystem::resize_file(path, offset + consumed, ec);
+    }
+    return offset + consumed;
+}
+
+bool appendWaitlist(const std::vector<WaitlistRecord>& records, const std::string& path) {
+    std::string text;
+    for (const auto& record : records) {
+        text += formatWaitlistRecord(record.op, record.entry);
+        text += '\n';
+    }
+    std::FILE* file = std::fopen(path.c_str(), "ab");
+    bool ok = file && std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (file) {
+        ok = syncFile(file) && ok;
+        ok = (std::fclose(file) == 0) && ok;
+    }
+    if (!ok) std::cerr << "Error: Could not write " << path << std::endl;
+    return ok;
+}
+
+bool saveWaitlist(const std::vector<WaitlistEntry>& entries, const std::string& path) {
+    std::error_code ec;
+    if (entries.empty()) {
+        std::filesystem::remove(path, ec);
+        return !ec;
+    }
+    std::string text;
+    for (const auto& entry : entries) {
+        text += formatWaitlistRecord('+', entry);
+        text += '\n';
+    }
+    return writeWhole(text, path);
+}
+
+bool isBinaryStore(const std::string& filename) {
+    return std::filesystem::path(filename).extension() == ".mbk";
+}
+
+std::string binaryOverflow(const Appointment& apt) {
+    struct Field {
+        const char* what;
+        std::string_view text;
+        size_t width;
+    };
+    for (const Field& field : {Field{"name", apt.name, sizeof(BinaryRecord::name)}, Field{"time", apt.time, sizeof(BinaryRecord::time)},
+                               Field{"service", apt.service, sizeof(BinaryRecord::service)},
+                               Field{"chair", apt.resource, sizeof(BinaryRecord::resource)}}) {
+        if (field.text.size() > field.width) {
+            return "The " + std::string(field.what) + " '" + std::string(field.text) + "' is too long for a binary store (" +
+                   std::to_string(field.width) + " characters max)";
+        }
+    }
+    // minutes are 16-bit there too: anything past that would wrap to a negative time or length
+    constexpr int maxMinutes = std::numeric_limits<std::int16_t>::max();
+    if (apt.duration < 0 || apt.duration > maxMinutes) {
+        return "The duration " + std::to_string(apt.duration) + " min is too long for a binary store (" +
+               std::to_string(maxMinutes) + " min max)";
+    }
+    if (apt.start < 0 || apt.start > maxMinutes) {
+        return "The time '" + std::string(apt.time) + "' is out of range for a binary store";
+    }
+    return std::string();
+}
+
+bool saveBinarySnapshot(const std::vector<Appointment>& appointments, const std::string& filename) {
+    std::vector<const Appointment*> sorted;
+    sorted.reserve(appointments.size());
+    for (const auto& apt : appointments) {
+        std::string overflow = binaryOverflow(apt);
+        if (!overflow.empty()) {
+            std::cerr << "Error: " << overflow << ": " << formatAppointmentRecord(apt) << std::endl;
+            return false;
+        }
+        sorted.push_back(&apt);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Appointment* a, const Appointment* b) {
+        return a->day != b->day ? a->day < b->day : a->start < b->start;
+    });
+    
+    std::vector<BinaryRecord> records(sorted.size());
+    std::vector<BinaryBlock> blocks;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const Appointment& apt = *sorted[i];
+        BinaryRecord& record = records[i];
+        std::memset(&record, 0, sizeof(record));
+        record.day = apt.day;
+        record.start = static_cast<std::int16_t>(apt.start);
+        record.duration = static_cast<std::int16_t>(apt.duration);
+        record.kind = static_cast<std::uint8_t>(apt.kind);
+        record.nameLength = static_cast<std::uint8_t>(apt.name.size());
+        record.timeLength = static_cast<std::uint8_t>(apt.time.size());
+        record.serviceLength = static_cast<std::uint8_t>(apt.service.size());
+        record.resourceLength = static_cast<std::uint8_t>(apt.resource.size());
+        std::memcpy(record.name, apt.name.data(), apt.name.size());
+        std::memcpy(record.time, apt.time.data(), apt.time.size());
+        std::memcpy(record.service, apt.service.data(), apt.service.size());
+        std::memcpy(record.resource, apt.resource.data(), apt.resource.size());
+        
+        if (i % binaryBlockRecords == 0) {
+            blocks.push_back(BinaryBlock{apt.day, apt.day, static_cast<std::uint32_t>(i), 0});
+        }
+        blocks.back().lastDay = apt.day;
+        ++blocks.back().recordCount;
+    }
+    
+    BinaryHeader header;
+    std::memcpy(header.magic, binaryMagic, sizeof(header.magic));
+    header.version = binaryFormatVersion;
+    header.recordSize = sizeof(BinaryRecord);
+    header.recordCount = records.size();
+    header.blockCount = static_cast<std::uint32_t>(blocks.size());
+    header.blockRecords = binaryBlockRecords;
+    
+    ScopedTimer timer(stats().save); // the write itself; sorting and packing above is CPU time
+    const std::string tmpName = filename + ".tmp";
+    std::FILE* file = std::fopen(tmpName.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Error: Could not open file for writing." << std::endl;
+        return false;
+    }
+    stats().snapshotBytes.fetch_add(sizeof(header) + records.size() * sizeof(BinaryRecord) + blocks.size() * sizeof(BinaryBlock),
+                                    std::memory_order_relaxed);
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && (records.empty() || std::fwrite(records.data(), sizeof(BinaryRecord), records.size(), file) == records.size());
+    ok = ok && (blocks.empty() || std::fwrite(blocks.data(), sizeof(BinaryBlock), blocks.size(), file) == blocks.size());
+    ok = syncFile(file) && ok;
+    ok = (std::fclose(file) == 0) && ok;
+    
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmpName, filename, ec);
+    if (!ok || ec) {
+        std::cerr << "Error: Could not write " << filename << std::endl;
+        std::filesystem::remove(tmpName, ec);
+        return false;
+    }
+    syncDirectory(std::filesystem::path(filename).parent_path().string());
+    return true;
+}
+
+void loadSnapshot(std::vector<Appointment>& appointments, const std::string& filename, TextArena& arena) {
+    if (isBinaryStore(filename)) {
+        ScopedTimer timer(stats().load);
+        BinarySnapshot snapshot;
+        if (snapshot.open(filename, arena)) snapshot.readAll(appointments, arena);
+    } else {
+        loadAppointments(appointments, filename, arena);
+    }
+}
+
+bool saveSnapshot(const std::vector<Appointment>& appointments, const std::string& filename) {
+    return isBinaryStore(filename) ? saveBinarySnapshot(appointments, filename) : saveAppointments(appointments, filename);
+}
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "appointment.h"
+#include "schedule.h"
+#include "waitlist.h"
+
+// Read-only view of a whole file: mmap'ed where available (so loading doesn't copy it),
+// read into one heap buffer otherwise
+class MappedFile {
+public:
+    MappedFile() = default;
+    
+    explicit MappedFile(const std::string& path);
+    
+    ~MappedFile();
+    
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        std::swap(bytes, other.bytes);
+        std::swap(length, other.length);
+        std::swap(opened, other.opened);
+        std::swap(mapped, other.mapped);
+        std::swap(buffer, other.buffer);
+        return *this;
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    bool isOpen() const { return opened; }
+    std::string_view view() const { return std::string_view(bytes ? bytes : "", length); }
+    
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+    bool mapped = false;
+    std::unique_ptr<char[]> buffer; // only used when the file is read instead of mapped
+};
+
+// Owns the text that Appointment's string_views point into: whole data files kept mapped,
+// plus bump-allocated chunks for text typed in at runtime. Nothing is freed until the arena goes away
+class TextArena {
+public:
+    static constexpr size_t chunkSize = 64 * 1024;
+    
+    // copy text into the arena and return a view of the copy
+    std::string_view store(std::string_view text) {
+        if (text.empty()) return std::string_view();
+        if (text.size() > chunkSize / 4) { // big blobs (a whole journal) get a chunk of their own
+            chunks.emplace_back(new char[text.size()]);
+            std::memcpy(chunks.back().get(), text.data(), text.size());
+            return std::string_view(chunks.back().get(), text.size());
+        }
+        if (used + text.size() > capacity) {
+            current = new char[chunkSize];
+            chunks.emplace_back(current);
+            used = 0;
+            capacity = chunkSize;
+        }
+        char* dest = current + used;
+        std::memcpy(dest, text.data(), text.size());
+        used += text.size();
+        return std::string_view(dest, text.size());
+    }
+    
+    // like store, but the same text stored before comes back as the same view rather than a new copy: a
+    // long-running session keeps typing in the same few names, services, dates and times
+    std::string_view intern(std::string_view text) {
+        if (text.empty()) return std::string_view();
+        auto found = interned.find(text);
+        if (found != interned.end()) return *found;
+        return *interned.insert(store(text)).first;
+    }
+    
+    // keep a mapped file alive for as long as the arena, returns its contents
+    std::string_view adopt(MappedFile&& file) {
+        files.push_back(std::move(file));
+        return files.back().view();
+    }
+    
+private:
+    std::vector<std::unique_ptr<char[]>> chunks;
+    std::vector<MappedFile> files;
+    std::unordered_set<std::string_view> interned; // views of intern()ed text, in the chunks
+    char* current = nullptr;
+    size_t used = 0;
+    size_t capacity = 0;
+};
+
+// Parse one "name|time|date|service|duration[|resource]" record in place: the text fields of apt point into line,
+// so line must outlive apt (it lives in a TextArena). Returns false if the line is malformed
+bool parseAppointmentRecord(std::string_view line, Appointment& apt);
+
+// Point the text fields of apt at interned copies in arena, for a record parsed out of text that isn't kept: a
+// process that keeps reading other processes' changes only keeps the names and dates it hasn't seen before
+void internAppointment(Appointment& apt, TextArena& arena);
+
+// Format an appointment as a "name|time|date|service|duration[|resource]" record (no newline).
+// The resource field is left off when it is empty, so single-chair files stay readable by older builds
+std::string formatAppointmentRecord(const Appointment& apt);
+
+// Call visit(line) for every newline-terminated line of text; returns the bytes consumed,
+// so a trailing partial line (a torn write) can be detected by comparing with text.size()
+template <typename Visit>
+size_t forEachLine(std::string_view text, Visit visit) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const void* newline = std::memchr(text.data() + pos, '\n', text.size() - pos);
+        if (!newline) break;
+        size_t end = static_cast<const char*>(newline) - text.data();
+        visit(text.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return pos;
+}
+
+// Load appointments from file
+// The file is mapped and kept alive by the arena, and records are scanned in place - no per-line strings
+void loadAppointments(std::vector<Appointment>& appointments, const std::string& filename, TextArena& arena); //passed by reference
+
+// Push a stdio file's data all the way to disk (fflush only hands it to the OS)
+bool syncFile(std::FILE* file);
+
+// Make a rename inside dir durable (no-op on Windows, where there is no directory fsync)
+void syncDirectory(const std::string& dir);
+
+// Save appointments to file "appointments.txt"
+// Writes to a temp file first and renames it over the old one, so a crash mid-write never loses the existing file
+bool saveAppointments(const std::vector<Appointment>& appointments, const std::string& filename);
+
+// Recurring rules live next to the store in "<store>.rules", one "weeks|lastDate|cancelled|record" line per
+// rule: lastDate is '-' for a rule without an end, cancelled is a comma-separated list of dates and record is
+// the first occurrence as a normal appointment record. Rules are few, so the file is rewritten on every change
+
+// Load the rules file (no file = no rules); their text is interned in the arena
+std::vector<RecurrenceRule> loadRules(const std::string& path, TextArena& arena);
+
+// Write the rules file atomically (temp file + rename); an empty rule list removes it
+bool saveRules(const std::vector<RecurrenceRule>& rules, const std::string& path);
+
+// The waitlist lives next to the store in "<store>.waitlist", a journal of its own: a "+|priority|lastDate|to|record"
+// line for each client who joins and the same line with '-' when they leave. to is the latest end time ('-' for
+// none) and record is what gets booked, with the first day as its date and the earliest start as its time. A change
+// only appends its lines; the file is rewritten whole, with just the clients still waiting, once it has grown well
+// past them
+
+// Read the complete records of the waitlist file from byte offset on into records, their text interned in the
+// arena. Returns the offset just past the last complete record; a torn one after it is cut off if truncateTorn is set
+size_t readWaitlist(const std::string& path, size_t offset, TextArena& arena, std::vector<WaitlistRecord>& records,
+                    bool truncateTorn = false);
+
+// Append records to the waitlist file and sync them
+bool appendWaitlist(const std::vector<WaitlistRecord>& records, const std::string& path);
+
+// Write the waitlist file atomically, a '+' record for each entry; an empty waitlist removes it
+bool saveWaitlist(const std::vector<WaitlistEntry>& entries, const std::string& path);
+
+// Binary snapshot format (*.mbk): a header, fixed-width records sorted by day then start time,
+// and a block index so a date range can be read without touching the rest of the file.
+// All integers are little-endian (x86 and the Raspberry Pi's ARM both are)
+constexpr char binaryMagic[8] = {'M', 'B', 'O', 'O', 'K', 'S', 'N', 'P'};
+constexpr std::uint32_t binaryFormatVersion = 2; // 2 added the resource field; version 1 files are still read
+constexpr std::uint32_t binaryBlockRecords = 64; // records per index block (5 KB of records)
+
+struct BinaryHeader {
+    char magic[8];               // binaryMagic
+    std::uint32_t version;       // binaryFormatVersion
+    std::uint32_t recordSize;    // sizeof(BinaryRecord), so a reader can reject a layout it doesn't know
+    std::uint64_t recordCount;
+    std::uint32_t blockCount;    // index entries, stored right after the records
+    std::uint32_t blockRecords;  // records per block (the last block may be short)
+};
+
+struct BinaryRecord {
+    std::int32_t day;            // days since 1970-01-01 (sort key)
+    std::int16_t start;          // minutes since midnight
+    std::int16_t duration;       // minutes
+    std::uint8_t kind;           // ServiceType
+    std::uint8_t nameLength;
+    std::uint8_t timeLength;
+    std::uint8_t serviceLength;
+    std::uint8_t resourceLength;
+    std::uint8_t reserved[3];    // zero
+    char name[36];
+    char time[8];                // as typed, e.g. "2:30pm"
+    char service[8];             // as typed, e.g. "haircut"
+    char resource[12];           // chair/barber, empty for the shop's first one
+};
+
+// version 1 record: the same without the resource
+struct BinaryRecordV1 {
+    std::int32_t day;
+    std::int16_t start;
+    std::int16_t duration;
+    std::uint8_t kind;
+    std::uint8_t nameLength;
+    std::uint8_t timeLength;
+    std::uint8_t serviceLength;
+    char name[36];
+    char time[8];
+    char service[8];
+};
+
+struct BinaryBlock {
+    std::int32_t firstDay;       // day of the block's first record
+    std::int32_t lastDay;        // day of the block's last record
+    std::uint32_t firstRecord;
+    std::uint32_t recordCount;
+};
+
+static_assert(sizeof(BinaryHeader) == 32, "BinaryHeader layout changed");
+static_assert(sizeof(BinaryRecord) == 80, "BinaryRecord layout changed");
+static_assert(sizeof(BinaryRecordV1) == 64, "BinaryRecordV1 layout changed");
+static_assert(sizeof(BinaryBlock) == 16, "BinaryBlock layout changed");
+
+// Binary snapshots are picked by file extension
+bool isBinaryStore(const std::string& filename);
+
+// Which of apt's fields doesn't fit the binary format (a text longer than its fixed width, minutes past 16 bits),
+// as a sentence for an error message; empty if they all fit
+std::string binaryOverflow(const Appointment& apt);
+
+// Write appointments as a binary snapshot (temp file + rename, like saveAppointments).
+// Fails if a field doesn't fit its fixed width
+bool saveBinarySnapshot(const std::vector<Appointment>& appointments, const std::string& filename);
+
+// Read side of a binary snapshot. The file stays mapped, so reading a date range only pages in
+// the index and the blocks covering that range; record text is used in place (zero-copy)
+class BinarySnapshot {
+public:
+    // map and validate the file; a missing file opens as an empty snapshot
+    // throws std::runtime_error if the file exists but isn't a snapshot this version can read
+    bool open(const std::string& filename, TextArena& arena) {
+        MappedFile file(filename);
+        if (!file.isOpen()) return false;
+        std::string_view bytes = arena.adopt(std::move(file));
+        
+        BinaryHeader header;
+        if (bytes.size() < sizeof(header)) throw std::runtime_error(filename + " is not a MirrorBooking snapshot");
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0) {
+            throw std::runtime_error(filename + " is not a MirrorBooking snapshot");
+        }
+        bool known = (header.version == binaryFormatVersion && header.recordSize == sizeof(BinaryRecord)) ||
+                     (header.version == 1 && header.recordSize == sizeof(BinaryRecordV1));
+        if (!known) {
+            throw std::runtime_error(filename + " uses snapshot format version " + std::to_string(header.version) +
+                                     ", this build reads versions 1 to " + std::to_string(binaryFormatVersion));
+        }
+        size_t recordBytes = static_cast<size_t>(header.recordCount) * header.recordSize;
+        if (bytes.size() != sizeof(header) + recordBytes + static_cast<size_t>(header.blockCount) * sizeof(BinaryBlock)) {
+            throw std::runtime_error(filename + " is truncated or corrupt");
+        }
+        const auto* index = reinterpret_cast<const BinaryBlock*>(bytes.data() + sizeof(header) + recordBytes);
+        // readRange indexes the records through the blocks and binary-searches them by day, so each block has to
+        // lie within the records and start no earlier than the one before it ends
+        for (std::uint32_t b = 0; b < header.blockCount; ++b) {
+            const BinaryBlock& block = index[b];
+            if (std::uint64_t(block.firstRecord) + block.recordCount > header.recordCount || block.firstDay > block.lastDay ||
+                (b > 0 && block.firstDay < index[b - 1].lastDay)) {
+                throw std::runtime_error(filename + " has a corrupt block index");
+            }
+        }
+        version = header.version;
+        records = bytes.data() + sizeof(header);
+        blocks = index;
+        recordCount = static_cast<size_t>(header.recordCount);
+        blockCount = header.blockCount;
+        return true;
+    }
+    
+    size_t size() const { return recordCount; }
+    
+    // append every appointment dated first..last (inclusive) to appointments
+    void readRange(int first, int last, std::vector<Appointment>& appointments, TextArena& arena) const {
+        if (version == 1) {
+            readRecords(reinterpret_cast<const BinaryRecordV1*>(records), first, last, appointments, arena);
+        } else {
+            readRecords(reinterpret_cast<const BinaryRecord*>(records), first, last, appointments, arena);
+        }
+    }
+    
+    // everything in the file
+    void readAll(std::vector<Appointment>& appointments, TextArena& arena) const {
+        if (blockCount == 0) return;
+        appointments.reserve(appointments.size() + recordCount);
+        readRange(blocks[0].firstDay, blocks[blockCount - 1].lastDay, appointments, arena);
+    }
+    
+private:
+    static std::string_view resourceOf(const BinaryRecord& record) {
+        return std::string_view(record.resource, std::min<size_t>(record.resourceLength, sizeof(record.resource)));
+    }
+    static std::string_view resourceOf(const BinaryRecordV1&) { return std::string_view(); }
+    
+    template <typename Record>
+    void readRecords(const Record* records, int first, int last, std::vector<Appointment>& appointments, TextArena& arena) const {
+        // first block that can hold day >= first
+        const BinaryBlock* block = std::lower_bound(blocks, blocks + blockCount, first,
+            [](const BinaryBlock& b, int day) { return b.lastDay < day; });
+        int cachedDay = 0;
+        std::string_view cachedDate;
+        for (; block != blocks + blockCount && block->firstDay <= last; ++block) {
+            for (std::uint32_t i = 0; i < block->recordCount; ++i) {
+                const Record& record = records[block->firstRecord + i];
+                if (record.day < first || record.day > last) continue;
+                if (cachedDate.empty() || record.day != cachedDay) { // one date string per day, not per record
+                    cachedDay = record.day;
+                    cachedDate = arena.store(daysToDate(record.day));
+                }
+                Appointment apt;
+                apt.name = std::string_view(record.name, std::min<size_t>(record.nameLength, sizeof(record.name)));
+                apt.time = std::string_view(record.time, std::min<size_t>(record.timeLength, sizeof(record.time)));
+                apt.service = std::string_view(record.service, std::min<size_t>(record.serviceLength, sizeof(record.service)));
+                apt.resource = resourceOf(record);
+                apt.date = cachedDate;
+                apt.duration = record.duration;
+                apt.start = record.start;
+                apt.day = record.day;
+                apt.kind = static_cast<ServiceType>(record.kind);
+                appointments.push_back(apt);
+            }
+        }
+    }
+    
+    std::uint32_t version = binaryFormatVersion;
+    const char* records = nullptr; // BinaryRecord, or BinaryRecordV1 for version 1 files
+    const BinaryBlock* blocks = nullptr;
+    size_t recordCount = 0;
+    size_t blockCount = 0;
+};
+
+// Load a whole snapshot, text or binary depending on the extension
+void loadSnapshot(std::vector<Appointment>& appointments, const std::string& filename, TextArena& arena);
+
+// Write a whole snapshot, text or binary depending on the extension
+bool saveSnapshot(const std::vector<Appointment>& appointments, const std::string& filename);
+
+// Read side of a text snapshot for on-demand paging. There is no index, so reading a range scans
+// every line, but lines outside the range only get their date field parsed and are never materialized
+class TextSnapshot {
+public:
+    bool open(const std::string& filename, TextArena& arena) {
+        MappedFile file(filename);
+        if (!file.isOpen()) return false;
+        text = arena.adopt(std::move(file));
+        return true;
+    }
+    
+    // records in the file (lines; a blank or malformed one is counted too)
+    size_t size() const {
+        return static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) + (!text.empty() && text.back() != '\n');
+    }
+    
+    // append every appointment dated first..last (inclusive) to appointments
+    void readRange(int first, int last, std::vector<Appointment>& appointments, TextArena&) const {
+        auto visit = [&](std::string_view line) {
+            size_t dateStart = line.find('|');
+            if (dateStart != std::string_view::npos) dateStart = line.find('|', dateStart + 1);
+            size_t dateEnd = dateStart == std::string_view::npos ? dateStart : line.find('|', dateStart + 1);
+            if (dateEnd == std::string_view::npos) return; // malformed, loadAppointments reports these
+            int day = 0;
+            try {
+                day = dateToDays(line.substr(dateStart + 1, dateEnd - dateStart - 1));
+            } catch (const std::invalid_argument&) {
+                return;
+            }
+            if (day < first || day > last) return;
+            Appointment apt;
+            if (parseAppointmentRecord(line, apt)) appointments.push_back(apt);
+        };
+        size_t consumed = forEachLine(text, visit);
+        if (consumed < text.size()) visit(text.substr(consumed));
+    }
+    
+private:
+    std::string_view text;
+};
@@ -0,0 +1,161 @@
+#include "storewatch.h"
+
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#endif
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+// whether any of store's files are there: a store that was only opened, never written to, has none
+static bool anyStoreFile(const std::string& store) {
+    for (const char* suffix : {"", ".journal", ".journal.compacting", ".rules", ".waitlist"}) {
+        if (StoreVersion::inodeOf(store + suffix)) return true;
+    }
+    return false;
+}
+
+StoreLock::StoreLock(const std::string& store, Mode mode) : path(store + ".lock"), store(store) {
+#ifndef _WIN32
+    while (true) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) return; // a read-only directory: nobody can write to the store, so nothing to guard
+        while (::flock(fd, mode == Mode::exclusive ? LOCK_EX : LOCK_SH) != 0 && errno == EINTR) {}
+        // the holder this one waited for may have removed the file on its way out: then lock the one there now
+        struct stat held, named;
+        if (::fstat(fd, &held) == 0 && ::stat(path.c_str(), &named) == 0 && held.st_ino == named.st_ino &&
+            held.st_dev == named.st_dev) {
+            return;
+        }
+        ::close(fd);
+    }
+#else
+    (void)mode;
+#endif
+}
+
+StoreLock::~StoreLock() {
+#ifndef _WIN32
+    if (fd < 0) return;
+    // no lock file left behind by a store that has no files (one that was opened and never written to), removed
+    // only with nobody else holding it; anyone waiting for it sees it gone and locks a new one
+    if (!anyStoreFile(store) && ::flock(fd, LOCK_EX | LOCK_NB) == 0 && !anyStoreFile(store)) ::unlink(path.c_str());
+    ::close(fd); // releases the lock
+#endif
+}
+
+// last write time of path in the file system's units, 0 if it isn't there
+static std::int64_t modifiedStamp(const std::string& path) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    return ec ? 0 : static_cast<std::int64_t>(time.time_since_epoch().count());
+}
+
+std::uint64_t StoreVersion::inodeOf(const std::string& path) {
+#ifndef _WIN32
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0 ? static_cast<std::uint64_t>(info.st_ino) : 0;
+#else
+    std::error_code ec;
+    return std::filesystem::exists(path, ec) ? 1 : 0;
+#endif
+}
+
+StoreVersion StoreVersion::of(const std::string& store) {
+    StoreVersion version;
+    const std::string journal = store + ".journal";
+    const std::string rules = store + ".rules";
+    const std::string waitlist = store + ".waitlist";
+    version.journalInode = inodeOf(journal);
+    if (version.journalInode) {
+        std::error_code ec;
+        version.journalBytes = std::filesystem::file_size(journal, ec);
+        if (ec) version.journalBytes = 0;
+    }
+    version.rulesInode = inodeOf(rules);
+    version.rulesModified = modifiedStamp(rules);
+    version.waitlistInode = inodeOf(waitlist);
+    if (version.waitlistInode) {
+        std::error_code ec;
+        version.waitlistBytes = std::filesystem::file_size(waitlist, ec);
+        if (ec) version.waitlistBytes = 0;
+    }
+    version.snapshotInode = inodeOf(store);
+    return version;
+}
+
+StoreWatcher::~StoreWatcher() {
+#ifdef __linux__
+    if (fd >= 0) ::close(fd);
+#endif
+}
+
+void StoreWatcher::open(const std::string& file) {
+    store = file;
+    std::filesystem::path path(file);
+    base = path.filename().string();
+    first = true;
+#ifdef __linux__
+    if (fd >= 0) ::close(fd);
+    fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return;
+    std::string dir = path.parent_path().string();
+    // the files are replaced by rename and the journal is rotated aside, so it is the directory that is watched
+    if (::inotify_add_watch(fd, dir.empty() ? "." : dir.c_str(),
+                            IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+bool StoreWatcher::changed() {
+    bool any = first;
+    first = false;
+#ifdef __linux__
+    if (fd >= 0) {
+        alignas(inotify_event) char events[4096];
+        while (true) {
+            ssize_t n = ::read(fd, events, sizeof(events));
+            if (n <= 0) break; // EAGAIN: nothing more for now
+            for (char* at = events; at < events + n;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(at);
+                std::string_view name = event->len ? std::string_view(event->name) : std::string_view();
+                if (name == base || name == base + ".journal" || name == base + ".journal.compacting" || name == base + ".rules" ||
+                    name == base + ".waitlist") {
+                    any = true;
+                }
+                if (event->mask & IN_Q_OVERFLOW) any = true; // events were lost: assume the worst
+                at += sizeof(inotify_event) + event->len;
+            }
+        }
+        return any;
+    }
+#endif
+    StoreVersion now = StoreVersion::of(store);
+    if (now != last || now.snapshotInode != last.snapshotInode) any = true;
+    last = now;
+    return any;
+}
+
+void StoreWatcher::wait(int timeoutMs) const {
+#ifdef __linux__
+    if (fd >= 0) {
+        pollfd ready{fd, POLLIN, 0};
+        ::poll(&ready, 1, timeoutMs); // woken early by a signal is fine too: the caller looks again
+        return;
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Several MirrorBooking processes can share one store (the front desk's prompt and the mirror, say). These are
+// the pieces that keep them from overwriting each other and let each one see the others' changes:
+//
+//  - StoreLock: an advisory lock on "<store>.lock". Every write to the store's files (journal appends, the rules
+//    and waitlist files, journal rotation, swapping in a folded snapshot, recovery) holds it exclusively; reading
+//    the journals holds it shared
+//  - StoreVersion: which journal file is live and how far it goes, and which rules and waitlist files. A process
+//    remembers the version it has caught up to; a write goes ahead only if the store is still at that version
+//    (optimistic check)
+//  - StoreWatcher: tells a process that one of the store's files changed, through inotify where there is one
+//    (Linux) and by comparing file stamps elsewhere
+
+// Held for as long as it lives; blocks until it is granted. A no-op where there is no flock() (Windows). The
+// lock file is removed again when the store has no files of its own
+class StoreLock {
+public:
+    enum class Mode { shared, exclusive };
+
+    explicit StoreLock(const std::string& store, Mode mode = Mode::exclusive);
+    ~StoreLock();
+
+    StoreLock(const StoreLock&) = delete;
+    StoreLock& operator=(const StoreLock&) = delete;
+
+private:
+    std::string path;
+    std::string store;
+    int fd = -1;
+};
+
+// The live journal (by inode; 0 if there is none) and its length, the rules file, and the waitlist and its length.
+// Compacting the journal into the snapshot doesn't change what the store holds, so the snapshot mostly isn't compared
+struct StoreVersion {
+    std::uint64_t journalInode = 0;
+    std::uint64_t journalBytes = 0;
+    std::uint64_t rulesInode = 0; // the rules file is replaced whole on every save
+    std::int64_t rulesModified = 0;
+    std::uint64_t waitlistInode = 0; // appended to like the journal, replaced when it is rewritten
+    std::uint64_t waitlistBytes = 0;
+    std::uint64_t snapshotInode = 0; // replaced by every fold: a journal that is gone was folded, not just dropped empty
+
+    // the store's current version, as its files are on disk now
+    static StoreVersion of(const std::string& store);
+
+    // inode of the file at path, 0 if there is none
+    static std::uint64_t inodeOf(const std::string& path);
+
+    bool sameRules(const StoreVersion& other) const { return rulesInode == other.rulesInode && rulesModified == other.rulesModified; }
+    bool sameWaitlist(const StoreVersion& other) const {
+        return waitlistInode == other.waitlistInode && waitlistBytes == other.waitlistBytes;
+    }
+    // nothing written between the two: the same journal as far, the same rules and waitlist. With no journal either time,
+    // a new snapshot means one came and was folded in between
+    bool operator==(const StoreVersion& other) const {
+        return journalInode == other.journalInode && journalBytes == other.journalBytes && sameRules(other) && sameWaitlist(other) &&
+               (journalInode != 0 || snapshotInode == other.snapshotInode);
+    }
+    bool operator!=(const StoreVersion& other) const { return !(*this == other); }
+};
+
+// Watches a store's files (the snapshot, its journals, its rules and its waitlist) for changes made by anyone, this process
+// included; the caller compares versions to find out whether there is anything it hasn't seen
+class StoreWatcher {
+public:
+    StoreWatcher() = default;
+    ~StoreWatcher();
+
+    StoreWatcher(const StoreWatcher&) = delete;
+    StoreWatcher& operator=(const StoreWatcher&) = delete;
+
+    // start watching store's directory; without inotify (or if it can't be set up) every changed() call stats the files
+    void open(const std::string& store);
+
+    // whether any of the store's files changed since the last call (true the first time). Never blocks
+    bool changed();
+
+    // becomes readable when changed() has something to say, for poll(); -1 when the files are polled instead
+    int pollFd() const { return fd; }
+
+    // block until changed() may have something to say, or for timeoutMs at most (all of it when polling the files)
+    void wait(int timeoutMs) const;
+
+private:
+    std::string store;
+    std::string base; // the store's file name without its directory
+    int fd = -1;
+    bool first = true;
+    StoreVersion last; // what changed() saw last when polling the files
+};
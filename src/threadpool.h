@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A fixed set of worker threads taking tasks off one queue. submit() hands back a future for the task's
+// result (or its exception); the destructor finishes what is queued and joins the workers
+class ThreadPool {
+public:
+    // one worker per hardware thread unless told otherwise (and at least one)
+    explicit ThreadPool(size_t workers = std::thread::hardware_concurrency()) {
+        workers = std::max<size_t>(workers, 1);
+        for (size_t i = 0; i < workers; ++i) threads.emplace_back([this]() { work(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) thread.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename Task>
+    auto submit(Task task) -> std::future<std::invoke_result_t<Task>> {
+        auto packaged = std::make_shared<std::packaged_task<std::invoke_result_t<Task>()>>(std::move(task));
+        auto result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            tasks.push([packaged]() { (*packaged)(); });
+        }
+        wake.notify_one();
+        return result;
+    }
+
+    // run task(i) for i in 0..count on the workers and wait for all of them; the first exception is rethrown
+    template <typename Task>
+    void forEach(size_t count, Task task) {
+        std::vector<std::future<void>> running;
+        running.reserve(count);
+        for (size_t i = 0; i < count; ++i) running.push_back(submit([&task, i]() { task(i); }));
+        for (auto& each : running) each.wait();
+        for (auto& each : running) each.get();
+    }
+
+    size_t size() const { return threads.size(); }
+
+private:
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(queueLock);
+                wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return; // stopping, and nothing left to do
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queueLock;
+    std::condition_variable wake;
+    bool stopping = false;
+};
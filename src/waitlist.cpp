@@ -0,0 +1,136 @@
+#include "waitlist.h"
+
+bool WaitlistEntry::sameAs(const WaitlistEntry& other) const {
+    return request.name == other.request.name && request.service == other.request.service &&
+           request.resource == other.request.resource && request.duration == other.request.duration &&
+           firstDay() == other.firstDay() && from() == other.from() && lastDay == other.lastDay && to == other.to &&
+           priority == other.priority;
+}
+
+std::vector<WaitlistEntry> Waitlist::entries() const {
+    std::vector<WaitlistEntry> waiting;
+    waiting.reserve(size());
+    forEach([&](const WaitlistEntry& entry) { waiting.push_back(entry); });
+    return waiting;
+}
+
+void Waitlist::assign(std::vector<WaitlistEntry> entries) {
+    list.clear();
+    list.reserve(entries.size());
+    lastJoined = 0;
+    for (auto& entry : entries) {
+        entry.joined = ++lastJoined;
+        list.push_back(Slot{std::move(entry)});
+    }
+    removed = 0;
+    dirty = true;
+}
+
+const WaitlistEntry& Waitlist::add(WaitlistEntry entry) {
+    if (entry.joined == 0) entry.joined = ++lastJoined;
+    lastJoined = std::max(lastJoined, entry.joined);
+    size_t position = positionOf(entry.joined);
+    if (position < list.size() && list[position].entry.joined == entry.joined) {
+        Slot& slot = list[position]; // left since the tree was built: back where it was
+        slot.entry = std::move(entry);
+        if (slot.gone) {
+            slot.gone = false;
+            --removed;
+            if (dirty) return slot.entry;
+            if (slot.node != unbuilt) {
+                nodes[slot.node].gone = false;
+            } else {
+                fresh.push_back(static_cast<std::uint32_t>(position));
+            }
+        }
+        return slot.entry;
+    }
+    if (position < list.size()) dirty = true; // in between: the positions after it move
+    list.insert(list.begin() + static_cast<std::ptrdiff_t>(position), Slot{std::move(entry)});
+    if (!dirty) fresh.push_back(static_cast<std::uint32_t>(position));
+    return list[position].entry;
+}
+
+bool Waitlist::remove(std::uint32_t joined) {
+    size_t position = positionOf(joined);
+    if (position == list.size() || list[position].entry.joined != joined || list[position].gone) return false;
+    Slot& slot = list[position];
+    slot.gone = true;
+    ++removed;
+    if (dirty) return true;
+    if (slot.node != unbuilt) {
+        nodes[slot.node].gone = true;
+    } else {
+        fresh.erase(std::find(fresh.begin(), fresh.end(), static_cast<std::uint32_t>(position)));
+    }
+    return true;
+}
+
+void Waitlist::apply(const WaitlistRecord& record) {
+    if (record.op == '+') {
+        WaitlistEntry entry = record.entry;
+        entry.joined = 0; // joins last
+        add(std::move(entry));
+    } else if (size_t position = find(record.entry); position != none) {
+        remove(list[position].entry.joined);
+    }
+}
+
+size_t Waitlist::find(const WaitlistEntry& entry) const {
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (!list[i].gone && list[i].entry.sameAs(entry)) return i;
+    }
+    return none;
+}
+
+size_t Waitlist::prune(int day) {
+    size_t pruned = 0;
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (!list[i].gone && list[i].entry.lastDay < day && remove(list[i].entry.joined)) ++pruned;
+    }
+    return pruned;
+}
+
+size_t Waitlist::match(int day, int start, int end, int from, int to, std::string_view chair) {
+    if (dirty || stale()) build();
+    size_t best = none;
+    int bestPriority = 0;
+    auto visit = [&](const Node& node) {
+        int earliest = std::max({start, node.from, from - node.duration + 1});
+        int latest = std::min({end, node.to, to + node.duration - 1}) - node.duration;
+        if (latest < earliest) return; // doesn't fit its hours, or only away from the freed time
+        if (best != none && (node.priority < bestPriority || (node.priority == bestPriority && node.entry > best))) return;
+        if (!node.anyChair && list[node.entry].entry.request.resource != chair) return;
+        best = node.entry;
+        bestPriority = node.priority;
+    };
+    stab(0, nodes.size(), day, visit);
+    for (std::uint32_t position : fresh) { // joined since the build: few enough to check one by one
+        const WaitlistEntry& entry = list[position].entry;
+        if (entry.firstDay() <= day && day <= entry.lastDay) visit(nodeOf(entry, position));
+    }
+    return best;
+}
+
+void Waitlist::build() {
+    // the ones who left go for good here, so this is where positions change
+    list.erase(std::remove_if(list.begin(), list.end(), [](const Slot& slot) { return slot.gone; }), list.end());
+    removed = 0;
+    nodes.clear();
+    nodes.reserve(list.size());
+    for (size_t i = 0; i < list.size(); ++i) nodes.push_back(nodeOf(list[i].entry, static_cast<std::uint32_t>(i)));
+    std::sort(nodes.begin(), nodes.end(), [](const Node& a, const Node& b) { return a.first < b.first; });
+    for (size_t n = 0; n < nodes.size(); ++n) list[nodes[n].entry].node = static_cast<std::uint32_t>(n);
+    if (!nodes.empty()) augment(0, nodes.size());
+    fresh.clear();
+    dirty = false;
+}
+
+int Waitlist::augment(size_t lo, size_t hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    Node& node = nodes[mid];
+    node.maxLast = node.last;
+    if (lo < mid) node.maxLast = std::max(node.maxLast, augment(lo, mid));
+    if (mid + 1 < hi) node.maxLast = std::max(node.maxLast, augment(mid + 1, hi));
+    return node.maxLast;
+}
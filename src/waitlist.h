@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "appointment.h"
+#include "config.h"
+
+// A client waiting for a slot to open up: any day from the first to lastDay, starting no earlier than `from` and
+// ending by `to`, on one chair or any. request is what gets booked: the name, service, duration and chair (empty
+// for any), with its date and time the first day and `from` as typed
+struct WaitlistEntry {
+    Appointment request;
+    int lastDay = 0;
+    int to = minutesPerDay; // latest end, minutes since midnight
+    int priority = 0;       // higher goes first; on a tie, whoever has waited longest
+    std::uint32_t joined = 0; // its place in the order of joining, given by the Waitlist (0: not on one yet)
+
+    int firstDay() const { return request.day; }
+    int from() const { return request.start; }
+
+    // where in the free stretch [start, end) the booking goes: as close to preferred as the entry's hours allow,
+    // or -1 if it doesn't fit in them
+    int startIn(int start, int end, int preferred) const {
+        int earliest = std::max(start, from());
+        int latest = std::min(end, to) - request.duration;
+        if (latest < earliest) return -1;
+        return std::clamp(preferred, earliest, latest);
+    }
+
+    // the same wait (joined aside): what a record of it leaving is matched against
+    bool sameAs(const WaitlistEntry& other) const;
+};
+
+// One record of the waitlist file: the entry joining ('+') or leaving ('-')
+struct WaitlistRecord {
+    char op = '+';
+    WaitlistEntry entry;
+};
+
+// The waitlist, in the order clients joined it, with an interval tree over their day windows: matching a freed
+// stretch only looks at the entries whose window covers its day, O(log n + those) rather than the whole list, so
+// it can run inside the del or reschedule that freed it. The tree is the windows sorted by first day, laid out as
+// an implicit balanced tree (the middle of each range is its root) with the latest last day below every node, so
+// a search skips the subtrees that end before the day.
+// A backfill takes its match off the list, so the tree follows changes instead of being rebuilt for each: whoever
+// leaves is only marked gone in their node and whoever joins is checked one by one next to the tree, until there
+// are enough of either (rebuildSlack, and a share of the list) to build it again without them
+class Waitlist {
+public:
+    static constexpr size_t none = static_cast<size_t>(-1);
+    static constexpr size_t rebuildSlack = 16;
+
+    // entries waiting
+    size_t size() const { return list.size() - removed; }
+    bool empty() const { return size() == 0; }
+
+    // the entry at position (as returned by match and find); positions hold until the next change
+    const WaitlistEntry& operator[](size_t position) const { return list[position].entry; }
+
+    // visit(entry) for everyone waiting, in the order they joined
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (const Slot& slot : list) {
+            if (!slot.gone) visit(slot.entry);
+        }
+    }
+
+    // everyone waiting, in the order they joined
+    std::vector<WaitlistEntry> entries() const;
+
+    // start over with entries (in the order they joined)
+    void assign(std::vector<WaitlistEntry> entries);
+
+    // put entry on the list: as the last to join, or back in its place if it was on it before (joined set).
+    // Returns it as it is on the list
+    const WaitlistEntry& add(WaitlistEntry entry);
+
+    // take whoever joined at joined off the list; false if they aren't on it
+    bool remove(std::uint32_t joined);
+
+    // a record of the waitlist file applied: its entry joins, or the first one the same as it leaves
+    void apply(const WaitlistRecord& record);
+
+    // position of the first entry waiting that is the same as entry, none if there is none
+    size_t find(const WaitlistEntry& entry) const;
+
+    // take everyone whose last day is before day off the list; how many that was
+    size_t prune(int day);
+
+    // the entry that should get the time freed at [from, to) on chair (named chair) on day, with [start, end) the
+    // free stretch around it: whoever waits for that day and chair and fits in the stretch within their hours,
+    // overlapping the freed time, highest priority first, then the one who joined first. none if nobody does
+    size_t match(int day, int start, int end, int from, int to, std::string_view chair);
+
+private:
+    static constexpr std::uint32_t unbuilt = static_cast<std::uint32_t>(-1); // joined since the tree was built
+
+    struct Slot {
+        WaitlistEntry entry;
+        std::uint32_t node = unbuilt; // its node in the tree
+        bool gone = false;            // left the list; dropped when the tree is built again
+    };
+
+    // an entry's window, and what the match checks first, kept in the node so a search stays in the tree
+    struct Node {
+        int first;
+        int last;
+        int maxLast; // the latest last day in the subtree rooted here
+        int from;
+        int to;
+        int duration;
+        int priority;
+        std::uint32_t entry; // its position in the list
+        bool anyChair;
+        bool gone;
+    };
+
+    static Node nodeOf(const WaitlistEntry& entry, std::uint32_t position) {
+        return Node{entry.firstDay(), entry.lastDay, entry.lastDay, entry.from(), entry.to, entry.request.duration,
+                    entry.priority, position, entry.request.resource.empty(), false};
+    }
+
+    // position of joined in the list (sorted by it), or where it would go
+    size_t positionOf(std::uint32_t joined) const {
+        return static_cast<size_t>(std::lower_bound(list.begin(), list.end(), joined,
+                                                    [](const Slot& slot, std::uint32_t j) { return slot.entry.joined < j; }) -
+                                   list.begin());
+    }
+
+    // whether the tree lags too far behind the list for matching around it to stay cheap
+    bool stale() const { return fresh.size() > rebuildSlack + list.size() / 32 || removed > rebuildSlack + list.size() / 4; }
+
+    void build();
+    int augment(size_t lo, size_t hi);
+
+    // call visit(node) for every entry whose window covers day, in the subtree over nodes[lo, hi)
+    template <typename Visit>
+    void stab(size_t lo, size_t hi, int day, Visit& visit) const {
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            const Node& node = nodes[mid];
+            if (node.maxLast < day) return; // everything below ends before day
+            stab(lo, mid, day, visit);
+            if (node.first > day) return; // and everything to the right starts after it
+            if (node.last >= day && !node.gone) visit(node);
+            lo = mid + 1;
+        }
+    }
+
+    std::vector<Slot> list;                // sorted by joined, the ones who left included until the next build
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> fresh;      // positions of the entries that joined since the build
+    size_t removed = 0;                    // slots in list that are gone
+    std::uint32_t lastJoined = 0;
+    bool dirty = false;                    // nodes (and fresh) don't match the list's positions any more
+};